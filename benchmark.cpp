@@ -0,0 +1,1295 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * benchmark.cpp
+ *
+ *  Timings of fixed_string operations against their usual
+ *  alternatives. Build the runBenchmarks target and run it; every
+ *  line reports the total and the average time per operation.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <unistd.h>
+#include <regex>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "fixed_string.hpp"
+#include "fixed_string_match.hpp"
+#include "fixed_string_aho_corasick.hpp"
+#include "fixed_string_switch.hpp"
+#include "fixed_string_batch.hpp"
+#include "fixed_string_serial.hpp"
+#include "fixed_string_hashed.hpp"
+#include "fixed_string_hybrid.hpp"
+#include "fixed_string_trie.hpp"
+#include "fixed_string_sorted_set.hpp"
+#include "fixed_string_bloom.hpp"
+#include "fixed_string_time.hpp"
+#include "fixed_string_log.hpp"
+
+//! keeps the compiler from optimizing away a benchmarked result
+static volatile int sink;
+
+//! Runs f iterations times and prints the time per call
+template<typename F>
+static void measure(const char * name, long iterations, F f) {
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (long j = 0; j < iterations; ++j)
+		f();
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+	std::cout << name << ": \t" << duration << "ns total, average : \t"
+			<< double(duration) / iterations << "ns." << std::endl;
+}
+
+//! Hardware counters of the calling thread through perf_event_open
+//! (Linux). A counter the kernel does not allow (perf_event_paranoid,
+//! containers) or the machine does not have is left out and reads -1;
+//! elsewhere none are available and only the time is reported.
+class perf_counters {
+public:
+	enum counter {
+		cycles, instructions, branches, branch_misses, l1d_misses, counters
+	};
+
+	perf_counters() :
+			error(0) {
+#if defined(__linux__)
+		const uint32_t types[counters] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+				PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE };
+		const uint64_t configs[counters] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+				PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_L1D
+						| (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) };
+		for (int c = 0; c < counters; c++) {
+			struct perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = types[c];
+			attr.config = configs[c];
+			attr.disabled = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			// more counters than the PMU has are multiplexed; the
+			// times let read() scale them up
+			attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			fds[c] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+			if (fds[c] < 0)
+				error = errno;
+		}
+#else
+		for (int c = 0; c < counters; c++)
+			fds[c] = -1;
+#endif
+	}
+
+	~perf_counters() {
+		for (int c = 0; c < counters; c++)
+			if (fds[c] >= 0)
+				close(fds[c]);
+	}
+
+	//! true if at least one counter could be opened
+	bool available() const {
+		for (int c = 0; c < counters; c++)
+			if (fds[c] >= 0)
+				return true;
+		return false;
+	}
+
+	//! errno of the last counter that could not be opened
+	int get_error() const {
+		return error;
+	}
+
+	void start() {
+#if defined(__linux__)
+		for (int c = 0; c < counters; c++)
+			if (fds[c] >= 0) {
+				ioctl(fds[c], PERF_EVENT_IOC_RESET, 0);
+				ioctl(fds[c], PERF_EVENT_IOC_ENABLE, 0);
+			}
+#endif
+	}
+
+	void stop() {
+#if defined(__linux__)
+		for (int c = 0; c < counters; c++)
+			if (fds[c] >= 0)
+				ioctl(fds[c], PERF_EVENT_IOC_DISABLE, 0);
+#endif
+	}
+
+	//! The count since start(), scaled for multiplexing, or -1
+	double read_counter(counter c) const {
+		uint64_t values[3];
+		if (fds[c] < 0 || read(fds[c], values, sizeof(values)) != sizeof(values) || values[2] == 0)
+			return -1;
+		return double(values[0]) * values[1] / values[2];
+	}
+
+private:
+	int fds[counters];
+	int error;
+};
+
+//! Runs f iterations times, as measure(), and adds per call the
+//! cycles, instructions per cycle, branches and branch misses, and
+//! the L1D misses per byte of the bytes one call handles
+template<typename F>
+static void measure_counters(const char * name, long iterations, int bytes, F f) {
+	perf_counters counters;
+	counters.start();
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (long j = 0; j < iterations; ++j)
+		f();
+	auto end = std::chrono::high_resolution_clock::now();
+	counters.stop();
+	auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+	char line[256];
+	std::snprintf(line, sizeof(line), "%-36s %9.1f ns", name, double(duration) / iterations);
+	std::cout << line;
+	if (!counters.available()) {
+		std::cout << "  (no counters: " << std::strerror(counters.get_error()) << ")" << std::endl;
+		return;
+	}
+	const double cycles = counters.read_counter(perf_counters::cycles);
+	const double instructions = counters.read_counter(perf_counters::instructions);
+	const double branches = counters.read_counter(perf_counters::branches);
+	const double misses = counters.read_counter(perf_counters::branch_misses);
+	const double l1d = counters.read_counter(perf_counters::l1d_misses);
+	// a counter that could not be opened prints as n/a
+	const char * columns[] = { "cycles", "IPC", "branches", "br-miss", "L1D/byte" };
+	const double values[] = { cycles / iterations, cycles > 0 && instructions >= 0 ? instructions / cycles : -1,
+			branches / iterations, misses / iterations, l1d >= 0 ? l1d / (double(bytes) * iterations) : -1 };
+	const bool known[] = { cycles >= 0, cycles > 0 && instructions >= 0, branches >= 0, misses >= 0, l1d >= 0 };
+	for (int c = 0; c < 5; c++) {
+		if (known[c])
+			std::snprintf(line, sizeof(line), "  %s %.*f", columns[c], c == 1 || c == 4 ? 3 : 1, values[c]);
+		else
+			std::snprintf(line, sizeof(line), "  %s n/a", columns[c]);
+		std::cout << line;
+	}
+	std::cout << std::endl;
+}
+
+//! pattern for the compile-time glob matcher
+constexpr char latency_pattern[] = "metrics.*.latency";
+constexpr char user_pattern[] = "user?_*";
+
+typedef fixed_string::fixed_string<64> key_string;
+
+//! A set of keys that looks like what a metrics pipeline
+//! classifies: mostly metric names, some user keys
+static std::vector<key_string> make_keys() {
+	static const char * metrics[] = { "latency", "throughput", "errors", "latency.p99" };
+	std::vector<key_string> keys;
+	char buff[64];
+	for (int i = 0; i < 1000; i++) {
+		if (i % 4 == 3)
+			std::snprintf(buff, sizeof(buff), "user%d_session_%d", i % 10, i);
+		else
+			std::snprintf(buff, sizeof(buff), "metrics.host%03d.%s", i, metrics[i % 4]);
+		keys.push_back(key_string(buff));
+	}
+	return keys;
+}
+
+static void benchmark_glob() {
+	std::cout << "--- glob matching, 1000 keys per iteration ---" << std::endl;
+	const std::vector<key_string> keys = make_keys();
+	const long iterations = 2000;
+
+	measure("match<P>", iterations, [&]() {
+		int n = 0;
+		for (const key_string & k : keys)
+			n += fixed_string::match<latency_pattern>(k) + fixed_string::match<user_pattern>(k);
+		sink = n;
+	});
+	measure("match(pattern)", iterations, [&]() {
+		int n = 0;
+		for (const key_string & k : keys)
+			n += fixed_string::match(latency_pattern, k) + fixed_string::match(user_pattern, k);
+		sink = n;
+	});
+	measure("fnmatch", iterations, [&]() {
+		int n = 0;
+		for (const key_string & k : keys)
+			n += (fnmatch(latency_pattern, k.c_str(), 0) == 0) + (fnmatch(user_pattern, k.c_str(), 0) == 0);
+		sink = n;
+	});
+	const std::regex latency_regex("metrics\\..*\\.latency");
+	const std::regex user_regex("user._.*");
+	measure("std::regex", iterations / 20, [&]() {
+		int n = 0;
+		for (const key_string & k : keys)
+			n += std::regex_match(k.c_str(), latency_regex) + std::regex_match(k.c_str(), user_regex);
+		sink = n;
+	});
+}
+
+static void benchmark_multi_pattern() {
+	std::cout << "--- 200 banned tokens, 1000 messages per iteration ---" << std::endl;
+	static fixed_string::aho_corasick<4096, 256> banned;
+	std::vector<fixed_string::fixed_string<16> > tokens;
+	char buff[128];
+	for (int i = 0; i < 200; i++) {
+		std::snprintf(buff, sizeof(buff), "tok%03dx", i * 7);
+		tokens.push_back(fixed_string::fixed_string<16>(buff));
+		banned.add(buff);
+	}
+	banned.build();
+
+	std::vector<fixed_string::fixed_string<128> > messages;
+	for (int i = 0; i < 1000; i++) {
+		std::snprintf(buff, sizeof(buff),
+				"user %d posted a message about topic %d with some text, token tok%03dx, end", i, i * 3, i);
+		messages.push_back(fixed_string::fixed_string<128>(buff));
+	}
+	const long iterations = 200;
+
+	measure("aho_corasick::count", iterations, [&]() {
+		int n = 0;
+		for (const fixed_string::fixed_string<128> & m : messages)
+			n += banned.count(m);
+		sink = n;
+	});
+	measure("strstr per token", iterations, [&]() {
+		int n = 0;
+		for (const fixed_string::fixed_string<128> & m : messages)
+			for (const fixed_string::fixed_string<16> & t : tokens)
+				n += std::strstr(m.c_str(), t.c_str()) != 0;
+		sink = n;
+	});
+}
+
+static void benchmark_keyword_switch() {
+	std::cout << "--- 200 keywords, 1000 lookups per iteration ---" << std::endl;
+	static char storage[200][16];
+	static const char * keywords[200];
+	for (int i = 0; i < 200; i++) {
+		std::snprintf(storage[i], sizeof(storage[i]), "keyword_%d", i * 13);
+		keywords[i] = storage[i];
+	}
+	static const fixed_string::string_table<200> table(keywords);
+
+	std::vector<fixed_string::fixed_string<16> > input;
+	for (int i = 0; i < 1000; i++)
+		input.push_back(fixed_string::fixed_string<16>(keywords[(i * 7) % 200]));
+	const long iterations = 1000;
+
+	measure("string_table::index", iterations, [&]() {
+		int n = 0;
+		for (const fixed_string::fixed_string<16> & fs : input)
+			n += table.index(fs);
+		sink = n;
+	});
+	measure("if (fs == ...) chain", iterations / 10, [&]() {
+		int n = 0;
+		for (const fixed_string::fixed_string<16> & fs : input)
+			for (int k = 0; k < 200; k++)
+				if (fs == keywords[k]) {
+					n += k;
+					break;
+				}
+		sink = n;
+	});
+}
+
+static void benchmark_batch_scaling() {
+	std::cout << "--- batch operations over 1M fixed_string<32> ---" << std::endl;
+	typedef fixed_string::fixed_string<32> value;
+	static value strings[1000000];
+	static uint64_t hashes[1000000];
+	char buff[32];
+	for (int i = 0; i < 1000000; i++) {
+		std::snprintf(buff, sizeof(buff), "session-%08lld-key", i * 7919LL);
+		strings[i] = buff;
+	}
+	const long iterations = 20;
+	for (int threads = 1; threads <= 32; threads *= 2) {
+		fixed_string::batch_pool pool(threads);
+		std::cout << threads << " thread(s)" << std::endl;
+		measure("hash_all", iterations, [&]() {
+			fixed_string::hash_all(&pool, strings, 1000000, hashes);
+			sink = hashes[12345];
+		});
+		measure("count_if", iterations, [&]() {
+			sink = fixed_string::count_if(&pool, strings, 1000000,
+					[](const value & fs) { return fs[8] == '0'; });
+		});
+	}
+}
+
+static void benchmark_serialization() {
+	std::cout << "--- serialization of 100000 fixed_string<32> ---" << std::endl;
+	typedef fixed_string::fixed_string<32> value;
+	static value strings[100000];
+	static value decoded[100000];
+	static fixed_string::serial::view views[100000];
+	static char wire[100000 * 40];
+	char buff[32];
+	for (int i = 0; i < 100000; i++) {
+		std::snprintf(buff, sizeof(buff), "field-%d", i * 31);
+		strings[i] = buff;
+	}
+	const long iterations = 100;
+	int bytes = 0;
+
+	measure("c_str + terminator, encode", iterations, [&]() {
+		char * p = wire;
+		for (int i = 0; i < 100000; i++) {
+			std::strcpy(p, strings[i].c_str());
+			p += strings[i].get_used_length() + 1;
+		}
+		sink = p - wire;
+	});
+	measure("c_str + terminator, decode", iterations, [&]() {
+		const char * p = wire;
+		for (int i = 0; i < 100000; i++) {
+			decoded[i] = p;
+			p += std::strlen(p) + 1;
+		}
+		sink = decoded[7].get_used_length();
+	});
+	measure("serial::encode_all", iterations, [&]() {
+		bytes = fixed_string::serial::encode_all(strings, 100000, wire, sizeof(wire));
+		sink = bytes;
+	});
+	measure("serial::decode_all (copy)", iterations, [&]() {
+		sink = fixed_string::serial::decode_all(wire, bytes, decoded, 100000);
+	});
+	measure("serial::decode_all (view)", iterations, [&]() {
+		sink = fixed_string::serial::decode_all(wire, bytes, views, 100000);
+	});
+	measure("serial::encode_all_padded", iterations, [&]() {
+		sink = fixed_string::serial::encode_all_padded(strings, 100000, wire, sizeof(wire), 32);
+	});
+	measure("serial::decode_all_padded", iterations, [&]() {
+		sink = fixed_string::serial::decode_all_padded(wire, sizeof(wire), decoded, 100000, 32);
+	});
+}
+
+static void benchmark_escaping() {
+	std::cout << "--- JSON escaping of 100000 log messages ---" << std::endl;
+	static std::string messages[100000];
+	char buff[128];
+	for (int i = 0; i < 100000; i++) {
+		std::snprintf(buff, sizeof(buff), (i % 10) ? "request %d served from cache in %d us by worker"
+				: "request %d failed: \"timeout\"\n\tretry %d", i, i % 997);
+		messages[i] = buff;
+	}
+	const long iterations = 50;
+
+	measure("per character into std::string", iterations, [&]() {
+		size_t n = 0;
+		for (const std::string & m : messages) {
+			std::string out;
+			for (char c : m) {
+				switch (c) {
+				case '"': out += "\\\""; break;
+				case '\\': out += "\\\\"; break;
+				case '\n': out += "\\n"; break;
+				case '\t': out += "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20) {
+						std::snprintf(buff, sizeof(buff), "\\u%04x", c);
+						out += buff;
+					} else
+						out += c;
+				}
+			}
+			n += out.size();
+		}
+		sink = n;
+	});
+	measure("fixed_string::append_json_escaped", iterations, [&]() {
+		size_t n = 0;
+		for (const std::string & m : messages) {
+			fixed_string::fixed_string<128> out;
+			out.append_json_escaped(m.data(), m.size());
+			n += out.get_used_length();
+		}
+		sink = n;
+	});
+}
+
+static void benchmark_append() {
+	std::cout << "--- building 1000 fixed_string<64> with += ---" << std::endl;
+	static fixed_string::fixed_string<64> strings[1000];
+	const long iterations = 1000;
+#if defined(DEFERREDTERMINATOR)
+	std::cout << "(DEFERREDTERMINATOR)" << std::endl;
+#endif
+	measure("+= char, 60 times", iterations, [&]() {
+		int n = 0;
+		for (fixed_string::fixed_string<64> & fs : strings) {
+			fs = "";
+			for (int i = 0; i < 60; i++)
+				fs += char('a' + i % 26);
+			n += fs.get_used_length();
+		}
+		sink = n;
+	});
+	measure("+= char, 60 times, then c_str", iterations, [&]() {
+		int n = 0;
+		for (fixed_string::fixed_string<64> & fs : strings) {
+			fs = "";
+			for (int i = 0; i < 60; i++)
+				fs += char('a' + i % 26);
+			n += fs.c_str()[59];
+		}
+		sink = n;
+	});
+	measure("+= char *, 10 times", iterations, [&]() {
+		int n = 0;
+		for (fixed_string::fixed_string<64> & fs : strings) {
+			fs = "";
+			for (int i = 0; i < 10; i++)
+				fs += "field,";
+			n += fs.get_used_length();
+		}
+		sink = n;
+	});
+}
+
+static void benchmark_literals() {
+	std::cout << "--- assigning and comparing literals, 1000 fixed_string<64> ---" << std::endl;
+	static fixed_string::fixed_string<64> strings[1000];
+	// the pointer cannot be seen through, so strlen() runs
+	const char * volatile pointer = "application/x-www-form-urlencoded";
+	const long iterations = 10000;
+	measure("= const char *", iterations, [&]() {
+		const char * p = pointer;
+		for (fixed_string::fixed_string<64> & fs : strings)
+			fs = p;
+		sink = strings[999].get_used_length();
+	});
+	measure("= literal", iterations, [&]() {
+		for (fixed_string::fixed_string<64> & fs : strings)
+			fs = "application/x-www-form-urlencoded";
+		sink = strings[999].get_used_length();
+	});
+	measure("== const char *", iterations, [&]() {
+		const char * p = pointer;
+		int n = 0;
+		for (fixed_string::fixed_string<64> & fs : strings)
+			n += fs == p;
+		sink = n;
+	});
+	measure("== literal", iterations, [&]() {
+		int n = 0;
+		for (fixed_string::fixed_string<64> & fs : strings)
+			n += fs == "application/x-www-form-urlencoded";
+		sink = n;
+	});
+}
+
+static void benchmark_std_string() {
+	std::cout << "--- 1000 std::strings of 40 characters into fixed_string<64> ---" << std::endl;
+	static fixed_string::fixed_string<64> strings[1000];
+	std::vector<std::string> sources;
+	for (int i = 0; i < 1000; i++)
+		sources.push_back(std::string(40, char('a' + i % 26)));
+	const long iterations = 10000;
+	measure("= s.c_str()", iterations, [&]() {
+		for (int i = 0; i < 1000; i++)
+			strings[i] = sources[i].c_str();
+		sink = strings[999].get_used_length();
+	});
+	measure("= s", iterations, [&]() {
+		for (int i = 0; i < 1000; i++)
+			strings[i] = sources[i];
+		sink = strings[999].get_used_length();
+	});
+	measure("== s.c_str()", iterations, [&]() {
+		int n = 0;
+		for (int i = 0; i < 1000; i++)
+			n += strings[i] == sources[i].c_str();
+		sink = n;
+	});
+	measure("== s", iterations, [&]() {
+		int n = 0;
+		for (int i = 0; i < 1000; i++)
+			n += strings[i] == sources[i];
+		sink = n;
+	});
+}
+
+static int length_of(const std::string & s) {
+	return s.size();
+}
+
+template<typename S>
+static int length_of(const S & s) {
+	return s.get_used_length();
+}
+
+//! Builds 10000 strings 4 characters at a time: most a little
+//! shorter than n, one in a thousand 2 * n long
+template<typename S>
+static void build_fields(int n) {
+	long total = 0;
+	for (int i = 0; i < 10000; i++) {
+		S s;
+		const int len = i % 1000 == 0 ? 2 * n : n - 8 + i % 8;
+		for (int j = 0; j < len; j += 4)
+			s.append("abcd", len - j < 4 ? len - j : 4);
+		total += length_of(s);
+	}
+	sink = total;
+}
+
+template<int N>
+static void benchmark_hybrid_at() {
+	std::cout << "--- 10000 strings of about " << N << " characters, 0.1% of " << 2 * N << " ---" << std::endl;
+	const long iterations = 100;
+	measure("std::string", iterations, []() {
+		build_fields<std::string>(N);
+	});
+	measure("fixed_string<N> (truncates)", iterations, []() {
+		build_fields<fixed_string::fixed_string<N> >(N);
+	});
+	measure("hybrid_string<N>, pool", iterations, []() {
+		build_fields<fixed_string::hybrid_string<N> >(N);
+	});
+	measure("hybrid_string<N>, heap", iterations, []() {
+		build_fields<fixed_string::hybrid_string<N, fixed_string::heap_allocator> >(N);
+	});
+}
+
+static void benchmark_hybrid() {
+	benchmark_hybrid_at<32>();
+	benchmark_hybrid_at<64>();
+	benchmark_hybrid_at<128>();
+}
+
+static void benchmark_hashed_keys() {
+	std::cout << "--- unordered_map lookups of 10000 48 character keys ---" << std::endl;
+	typedef fixed_string::fixed_string<48> plain_key;
+	typedef fixed_string::hashed_fixed_string<48> hashed_key;
+	std::vector<plain_key> plain_keys;
+	std::vector<hashed_key> hashed_keys;
+	std::unordered_map<plain_key, int> plain_map;
+	std::unordered_map<hashed_key, int> hashed_map;
+	char buff[64];
+	for (int i = 0; i < 10000; i++) {
+		std::snprintf(buff, sizeof(buff), "metrics.datacenter-%02d.rack-%03d.host-%05d.cpu", i % 7, i % 101, i);
+		plain_keys.push_back(plain_key(buff));
+		hashed_keys.push_back(hashed_key(buff));
+		plain_map[plain_key(buff)] = i;
+		hashed_map[hashed_key(buff)] = i;
+	}
+	const long iterations = 100;
+	measure("fixed_string<48> keys", iterations, [&]() {
+		int n = 0;
+		for (const plain_key & k : plain_keys)
+			n += plain_map.find(k)->second;
+		sink = n;
+	});
+	measure("hashed_fixed_string<48> keys", iterations, [&]() {
+		int n = 0;
+		for (const hashed_key & k : hashed_keys)
+			n += hashed_map.find(k)->second;
+		sink = n;
+	});
+}
+
+static void benchmark_trie() {
+	std::cout << "--- prefix scans over 20000 region/host/metric keys ---" << std::endl;
+	static fixed_string::fixed_string_trie<48, int, 40000> trie;
+	std::map<std::string, int> map;
+	static const char * metrics[] = { "cpu", "mem", "disk", "net" };
+	char buff[48];
+	for (int i = 0; i < 20000; i++) {
+		std::snprintf(buff, sizeof(buff), "region-%d/host-%04d/%s", i % 8, i / 4 % 5000, metrics[i % 4]);
+		trie.insert(buff, i);
+		map[buff] = i;
+	}
+	std::vector<fixed_string::fixed_string<48> > prefixes;
+	for (int i = 0; i < 1000; i++) {
+		std::snprintf(buff, sizeof(buff), "region-%d/host-%03d", i % 8, i % 500);
+		prefixes.push_back(buff);
+	}
+	const long iterations = 100;
+	measure("std::map lower_bound scan", iterations, [&]() {
+		int n = 0;
+		for (const fixed_string::fixed_string<48> & p : prefixes) {
+			const std::string prefix(p.c_str(), p.get_used_length());
+			for (auto it = map.lower_bound(prefix);
+					it != map.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it)
+				n += it->second;
+		}
+		sink = n;
+	});
+	measure("fixed_string_trie::for_each_prefix", iterations, [&]() {
+		int n = 0;
+		for (const fixed_string::fixed_string<48> & p : prefixes)
+			trie.for_each_prefix(p, [&](const fixed_string::fixed_string<0> &, int v) { n += v; });
+		sink = n;
+	});
+	measure("std::map find", iterations, [&]() {
+		int n = 0;
+		for (const fixed_string::fixed_string<48> & p : prefixes) {
+			auto it = map.find(std::string(p.c_str(), p.get_used_length()) + "0/cpu");
+			n += it != map.end();
+		}
+		sink = n;
+	});
+	measure("fixed_string_trie::find", iterations, [&]() {
+		int n = 0;
+		for (fixed_string::fixed_string<48> p : prefixes) {
+			p += "0/cpu";
+			n += trie.find(p) != 0;
+		}
+		sink = n;
+	});
+}
+
+static void benchmark_sorted_set() {
+	std::cout << "--- lower_bound in 100000 sorted fixed_string<32> ---" << std::endl;
+	typedef fixed_string::fixed_string<32> value;
+	static value strings[100000];
+	static value queries[10000];
+	static fixed_string::sorted_fixed_string_set<32, 100000> set;
+	char buff[32];
+	for (int i = 0; i < 100000; i++) {
+		std::snprintf(buff, sizeof(buff), "sym_%08x_%d", i * 2654435761u, i % 13);
+		strings[i] = buff;
+	}
+	for (int i = 0; i < 10000; i++)
+		queries[i] = strings[(i * 7919) % 100000];
+	set.build(strings, 100000);
+	std::sort(strings, strings + 100000);
+	const long iterations = 100;
+	measure("std::lower_bound with compare()", iterations, [&]() {
+		int n = 0;
+		for (const value & q : queries)
+			n += std::lower_bound(strings, strings + 100000, q) - strings;
+		sink = n;
+	});
+	measure("sorted_fixed_string_set::lower_bound", iterations, [&]() {
+		int n = 0;
+		for (const value & q : queries)
+			n += set.lower_bound(q);
+		sink = n;
+	});
+}
+
+static void benchmark_bloom() {
+	std::cout << "--- 1M lookups in a set of 100000 identifiers, 90 % misses ---" << std::endl;
+	typedef fixed_string::fixed_string<32> value;
+	static value known[100000];
+	static value queries[1000000];
+	static bool maybe[1000000];
+	static fixed_string::bloom_filter<100000, 10> filter;
+	static fixed_string::blocked_bloom_filter<100000, 10> blocked;
+	std::unordered_set<value> set;
+	char buff[32];
+	for (int i = 0; i < 100000; i++) {
+		std::snprintf(buff, sizeof(buff), "ident_%d", i * 10);
+		known[i] = buff;
+		set.insert(known[i]);
+	}
+	filter.insert_all(known, 100000);
+	blocked.insert_all(known, 100000);
+	for (int i = 0; i < 1000000; i++) {
+		std::snprintf(buff, sizeof(buff), "ident_%d", i);
+		queries[i] = buff;
+	}
+	const long iterations = 10;
+	measure("unordered_set::count", iterations, [&]() {
+		int n = 0;
+		for (const value & q : queries)
+			n += set.count(q);
+		sink = n;
+	});
+	measure("bloom_filter, then unordered_set::count", iterations, [&]() {
+		int n = 0;
+		for (const value & q : queries)
+			n += filter.maybe_contains(q) && set.count(q);
+		sink = n;
+	});
+	measure("blocked_bloom_filter, then unordered_set::count", iterations, [&]() {
+		int n = 0;
+		for (const value & q : queries)
+			n += blocked.maybe_contains(q) && set.count(q);
+		sink = n;
+	});
+	measure("blocked_bloom_filter::maybe_contains_all, then count", iterations, [&]() {
+		blocked.maybe_contains_all(queries, 1000000, maybe);
+		int n = 0;
+		for (int i = 0; i < 1000000; i++)
+			n += maybe[i] && set.count(queries[i]);
+		sink = n;
+	});
+}
+
+static void benchmark_normalize() {
+	std::cout << "--- normalizing 100000 header values ---" << std::endl;
+	static fixed_string::fixed_string<64> values[100000];
+	static fixed_string::fixed_string<64> out[100000];
+	for (int i = 0; i < 100000; i++) {
+		values[i] = "   Content-Type: Text/HTML; charset=UTF-8 ";
+		values[i] += char('A' + i % 26);
+		values[i] += " \t\r\n";
+	}
+	const long iterations = 50;
+	measure("per character operator[], tolower()", iterations, [&]() {
+		for (int i = 0; i < 100000; i++) {
+			const fixed_string::fixed_string<64> & v = values[i];
+			int b = 0;
+			int e = v.get_used_length();
+			while (b < e && std::isspace(static_cast<unsigned char>(v[b])))
+				b++;
+			while (e > b && std::isspace(static_cast<unsigned char>(v[e - 1])))
+				e--;
+			out[i] = "";
+			for (int j = b; j < e; j++)
+				out[i] += char(std::tolower(static_cast<unsigned char>(v[j])));
+		}
+		sink = out[99].get_used_length();
+	});
+	measure("fixed_string::trim_into, to_lower", iterations, [&]() {
+		for (int i = 0; i < 100000; i++) {
+			values[i].trim_into(out[i]);
+			out[i].to_lower();
+		}
+		sink = out[99].get_used_length();
+	});
+	measure("per character isspace() removal", iterations, [&]() {
+		for (int i = 0; i < 100000; i++) {
+			out[i] = "";
+			for (int j = 0; j < values[i].get_used_length(); j++)
+				if (!std::isspace(static_cast<unsigned char>(values[i][j])))
+					out[i] += values[i][j];
+		}
+		sink = out[99].get_used_length();
+	});
+	measure("fixed_string::remove_if_into(space)", iterations, [&]() {
+		for (int i = 0; i < 100000; i++)
+			values[i].remove_if_into(fixed_string::chars::space, out[i]);
+		sink = out[99].get_used_length();
+	});
+}
+
+static void benchmark_hex_base64() {
+	std::cout << "--- encoding 100000 32 byte digests ---" << std::endl;
+	static unsigned char digests[100000][32];
+	static fixed_string::fixed_string<64> hex[100000];
+	static fixed_string::fixed_string<44> b64[100000];
+	static const char digits[] = "0123456789abcdef";
+	for (int i = 0; i < 100000; i++)
+		for (int j = 0; j < 32; j++)
+			digests[i][j] = (i * 131 + j * 7) ^ (i >> 3);
+	const long iterations = 50;
+	measure("hex, per character into std::string", iterations, [&]() {
+		for (int i = 0; i < 100000; i++) {
+			std::string s;
+			for (int j = 0; j < 32; j++) {
+				s += digits[digests[i][j] >> 4];
+				s += digits[digests[i][j] & 15];
+			}
+			hex[i] = s.c_str();
+		}
+		sink = hex[99].get_used_length();
+	});
+	measure("fixed_string::append_hex", iterations, [&]() {
+		for (int i = 0; i < 100000; i++) {
+			hex[i] = "";
+			hex[i].append_hex(digests[i], 32);
+		}
+		sink = hex[99].get_used_length();
+	});
+	unsigned char back[32];
+	measure("fixed_string::decode_hex_into", iterations, [&]() {
+		int n = 0;
+		for (int i = 0; i < 100000; i++)
+			n += hex[i].decode_hex_into(back, sizeof(back));
+		sink = n;
+	});
+	measure("base64, per character into std::string", iterations, [&]() {
+		static const char * a = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		for (int i = 0; i < 100000; i++) {
+			std::string s;
+			const unsigned char * d = digests[i];
+			for (int j = 0; j < 32; j += 3) {
+				const unsigned v = (d[j] << 16) | (j + 1 < 32 ? d[j + 1] << 8 : 0) | (j + 2 < 32 ? d[j + 2] : 0);
+				s += a[v >> 18];
+				s += a[(v >> 12) & 63];
+				s += j + 1 < 32 ? a[(v >> 6) & 63] : '=';
+				s += j + 2 < 32 ? a[v & 63] : '=';
+			}
+			b64[i] = s.c_str();
+		}
+		sink = b64[99].get_used_length();
+	});
+	measure("fixed_string::append_base64", iterations, [&]() {
+		for (int i = 0; i < 100000; i++) {
+			b64[i] = "";
+			b64[i].append_base64(digests[i], 32);
+		}
+		sink = b64[99].get_used_length();
+	});
+	measure("fixed_string::decode_base64_into", iterations, [&]() {
+		int n = 0;
+		for (int i = 0; i < 100000; i++)
+			n += b64[i].decode_base64_into(back, sizeof(back));
+		sink = n;
+	});
+}
+
+static void benchmark_timestamp() {
+	std::cout << "--- 1M ISO-8601 timestamps, 1 us apart ---" << std::endl;
+	typedef std::chrono::system_clock clock;
+	const clock::time_point start = clock::now();
+	const long iterations = 5;
+	fixed_string::fixed_string<64> record;
+	measure("strftime + snprintf, appended per character", iterations, [&]() {
+		int n = 0;
+		for (int i = 0; i < 1000000; i++) {
+			const clock::time_point t = start + std::chrono::microseconds(i);
+			const long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+			const time_t second = time_t(ns / 1000000000);
+			struct tm tm;
+			gmtime_r(&second, &tm);
+			char scratch[40];
+			const int len = strftime(scratch, sizeof(scratch), "%Y-%m-%dT%H:%M:%S", &tm);
+			std::snprintf(scratch + len, sizeof(scratch) - len, ".%03dZ", int(ns / 1000000 % 1000));
+			record = "";
+			for (const char * p = scratch; *p; p++)
+				record += *p;
+			n += record.get_used_length();
+		}
+		sink = n;
+	});
+	measure("append_timestamp", iterations, [&]() {
+		int n = 0;
+		for (int i = 0; i < 1000000; i++) {
+			record = "";
+			fixed_string::append_timestamp(record, start + std::chrono::microseconds(i));
+			n += record.get_used_length();
+		}
+		sink = n;
+	});
+	measure("append_timestamp(clock::now())", iterations, [&]() {
+		int n = 0;
+		for (int i = 0; i < 1000000; i++) {
+			record = "";
+			fixed_string::append_timestamp(record, clock::now(), fixed_string::timestamp::microseconds);
+			n += record.get_used_length();
+		}
+		sink = n;
+	});
+}
+
+//! Runs threads threads that each call f(thread, i) calls times and
+//! prints the percentiles of the time per call
+template<typename F>
+static void measure_latency(const char * name, int threads, int calls, F f) {
+	static long long samples[4 * 100000];
+	std::thread workers[4];
+	for (int t = 0; t < threads; t++)
+		workers[t] = std::thread([&f, t, calls]() {
+			for (int i = 0; i < calls; i++) {
+				auto begin = std::chrono::steady_clock::now();
+				f(t, i);
+				auto end = std::chrono::steady_clock::now();
+				samples[t * calls + i] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+			}
+		});
+	for (int t = 0; t < threads; t++)
+		workers[t].join();
+	const int n = threads * calls;
+	std::sort(samples, samples + n);
+	std::cout << name << ", " << threads << " thread(s): \tp50 " << samples[n / 2] << "ns, p99 "
+			<< samples[n * 99LL / 100] << "ns, p99.9 " << samples[n * 999LL / 1000] << "ns, max "
+			<< samples[n - 1] << "ns" << std::endl;
+}
+
+static void benchmark_logger() {
+	std::cout << "--- log call latency, 100000 records per thread to /dev/null ---" << std::endl;
+	const int fd = open("/dev/null", O_WRONLY);
+	std::mutex lock;
+	for (int threads = 1; threads <= 4; threads *= 2) {
+		measure_latency("std::string + mutex + write", threads, 100000, [&](int t, int i) {
+			std::string line = "worker ";
+			line += std::to_string(t);
+			line += " handled request ";
+			line += std::to_string(i);
+			line += '\n';
+			std::lock_guard<std::mutex> guard(lock);
+			sink = write(fd, line.data(), line.size());
+		});
+		typedef fixed_string::fixed_string_logger<128, 4096> logger;
+		static logger log(fd, logger::block);
+		measure_latency("fixed_string_logger, block", threads, 100000, [&](int t, int i) {
+			log.log([t, i](fixed_string::fixed_string<0> & r) {
+				r += "worker ";
+				r += char('0' + t);
+				r += " handled request ";
+				char digits[12];
+				r.append(digits, std::snprintf(digits, sizeof(digits), "%d", i));
+			});
+		});
+		log.flush();
+	}
+	close(fd);
+}
+
+//! Latency histogram after HdrHistogram: values below 64 ns have a
+//! bucket each, above that every power of two is split into 32
+//! buckets, so a value is known to within 1/32 (3 %) at any scale.
+//! A fixed array covers all of uint64_t; recording never allocates.
+class latency_histogram {
+public:
+	static const int sub_bits = 5;
+	static const int sub_buckets = 1 << sub_bits;
+	static const int buckets = (64 - sub_bits + 1) * sub_buckets;
+
+	latency_histogram() {
+		clear();
+	}
+
+	void clear() {
+		std::memset(counts, 0, sizeof(counts));
+		total = 0;
+		sum = 0;
+		max = 0;
+	}
+
+	void record(uint64_t ns) {
+		counts[index(ns)]++;
+		total++;
+		sum += ns;
+		if (ns > max)
+			max = ns;
+	}
+
+	void merge(const latency_histogram & rhs) {
+		for (int i = 0; i < buckets; i++)
+			counts[i] += rhs.counts[i];
+		total += rhs.total;
+		sum += rhs.sum;
+		if (rhs.max > max)
+			max = rhs.max;
+	}
+
+	//! The value that a fraction p of the samples do not exceed: the
+	//! upper edge of its bucket, never more than the largest sample
+	uint64_t percentile(double p) const {
+		uint64_t rank = uint64_t(p * total + 0.5);
+		if (rank < 1)
+			rank = 1;
+		uint64_t seen = 0;
+		for (int i = 0; i < buckets; i++) {
+			seen += counts[i];
+			if (seen >= rank)
+				return upper(i) < max ? upper(i) : max;
+		}
+		return max;
+	}
+
+	uint64_t get_count() const {
+		return total;
+	}
+
+	uint64_t get_max() const {
+		return max;
+	}
+
+	double get_mean() const {
+		return total ? double(sum) / total : 0;
+	}
+
+private:
+	static int index(uint64_t v) {
+		if (v < 2 * sub_buckets)
+			return int(v);
+#if defined(__GNUC__)
+		const int log2 = 63 - __builtin_clzll(v);
+#else
+		int log2 = 0;
+		while ((v >> log2) > 1)
+			log2++;
+#endif
+		const int shift = log2 - sub_bits;
+		return shift * sub_buckets + int(v >> shift);
+	}
+
+	//! the largest value that lands in bucket i
+	static uint64_t upper(int i) {
+		if (i < 2 * sub_buckets)
+			return i;
+		const int shift = i / sub_buckets - 1;
+		return ((uint64_t(i - shift * sub_buckets) + 1) << shift) - 1;
+	}
+
+	uint64_t counts[buckets];
+	uint64_t total;
+	uint64_t sum;
+	uint64_t max;
+};
+
+//! Pieces of the records built by the tail latency workloads: the
+//! lengths vary from 25 to 130 characters, beyond the inline
+//! buffer of std::string and across several heap size classes
+static const char * const record_users[] = { "u1", "user-0042", "service-account-ingest-pipeline-eu-west" };
+static const char * const record_actions[] = { "get", "update-preferences", "delete" };
+static const char * const record_paths[] = { "/", "/api/v1/orders/2024/11/items?expand=customer,shipping",
+		"/health", "/api/v1/users/0042/sessions" };
+
+//! Builds record i into s, piece by piece, the way log lines and
+//! protocol fields are built
+template<typename S>
+static void build_record(S & s, int i) {
+	s = "user=";
+	s += record_users[i % 3];
+	s += " action=";
+	s += record_actions[(i / 3) % 3];
+	s += " path=";
+	s += record_paths[(i / 9) % 4];
+}
+
+//! The length record i should have, to spot truncated records
+static int record_length(int i) {
+	return 5 + std::strlen(record_users[i % 3]) + 8 + std::strlen(record_actions[(i / 3) % 3]) + 6
+			+ std::strlen(record_paths[(i / 9) % 4]);
+}
+
+//! One thread of a tail latency run: builds a record per call into a
+//! window of 1000 strings that stay alive, so heap strings are freed
+//! in a different order than allocated and the heap fragments
+template<typename S>
+class record_worker {
+public:
+	record_worker() :
+			window(1000), truncated(0) {
+	}
+
+	void operator()(int i) {
+		S s;
+		build_record(s, i);
+		window[(i * 7) % window.size()] = s;
+		truncated += length_of(s) != record_length(i);
+	}
+
+	//! records that did not get all their characters; a run with
+	//! any measured less work than it claims
+	long get_truncated() const {
+		return truncated;
+	}
+
+private:
+	std::vector<S> window;
+	long truncated;
+};
+
+//! Only the clock reads: the overhead included in every sample
+class clock_worker {
+public:
+	void operator()(int) {
+	}
+
+	long get_truncated() const {
+		return 0;
+	}
+};
+
+//! hybrid_string of the tail latency runs, with a pool of its own:
+//! 1000 live records per thread in blocks of 256 bytes leave room
+//! for about 60 threads
+typedef fixed_string::hybrid_string<64, fixed_string::pool_allocator<(16 << 20)> > tail_hybrid;
+
+//! Runs calls calls of a W per thread on threads threads, which start
+//! together, and prints the latency percentiles of all calls; as one
+//! JSON object per line if json is set
+template<typename W>
+static void measure_tail_latency(const char * name, int threads, int calls, bool json) {
+	std::vector<latency_histogram> histograms(threads);
+	std::vector<std::thread> workers;
+	std::atomic<int> ready(0);
+	std::atomic<long> truncated(0);
+	for (int t = 0; t < threads; t++)
+		workers.push_back(std::thread([&histograms, &ready, &truncated, t, threads, calls]() {
+			W work;
+			latency_histogram & h = histograms[t];
+			ready++;
+			while (ready.load() < threads)
+				std::this_thread::yield();
+			for (int i = 0; i < calls; i++) {
+				auto begin = std::chrono::steady_clock::now();
+				work(i + t * 13);
+				auto end = std::chrono::steady_clock::now();
+				h.record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+			}
+			truncated += work.get_truncated();
+		}));
+	for (std::thread & w : workers)
+		w.join();
+	latency_histogram all;
+	for (const latency_histogram & h : histograms)
+		all.merge(h);
+	char line[512];
+	if (json)
+		std::snprintf(line, sizeof(line), "{\"benchmark\":\"tail_latency\",\"workload\":\"%s\",\"threads\":%d,"
+				"\"calls\":%llu,\"mean_ns\":%.1f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu,"
+				"\"truncated\":%ld}",
+				name, threads, (unsigned long long) all.get_count(), all.get_mean(),
+				(unsigned long long) all.percentile(0.5), (unsigned long long) all.percentile(0.99),
+				(unsigned long long) all.percentile(0.999), (unsigned long long) all.get_max(), truncated.load());
+	else
+		std::snprintf(line, sizeof(line), "%-24s %2d thread(s): mean %7.1fns, p50 %6llu, p99 %6llu, p99.9 %7llu, max %9llu%s",
+				name, threads, all.get_mean(), (unsigned long long) all.percentile(0.5),
+				(unsigned long long) all.percentile(0.99), (unsigned long long) all.percentile(0.999),
+				(unsigned long long) all.get_max(), truncated.load() ? " (TRUNCATED)" : "");
+	if (!json && truncated.load())
+		std::snprintf(line + std::strlen(line), sizeof(line) - std::strlen(line), " %ld records cut short",
+				truncated.load());
+	std::cout << line << std::endl;
+}
+
+//! Tail latency of building records on 1 to max_threads threads at
+//! once: heap strings contend for the allocator and fragment it,
+//! fixed_strings do neither
+static void benchmark_tail_latency(int max_threads, int calls, bool json) {
+	if (!json)
+		std::cout << "--- tail latency of building records, " << calls << " per thread ---" << std::endl;
+	for (int threads = 1; threads <= max_threads; threads *= 2) {
+		measure_tail_latency<clock_worker>("clock only", threads, calls, json);
+		measure_tail_latency<record_worker<std::string> >("std::string", threads, calls, json);
+		measure_tail_latency<record_worker<fixed_string::fixed_string<160> > >("fixed_string<160>", threads, calls, json);
+		measure_tail_latency<record_worker<tail_hybrid> >("hybrid_string<64>", threads, calls, json);
+	}
+}
+
+//! Core operations on a fixed_string<64>, under the hardware counters:
+//! where the time goes, e.g. the branches of the per-character checks
+//! of append(char) against a single append(s, len)
+static void benchmark_counters() {
+	std::cout << "--- hardware counters per call, fixed_string<64> ---" << std::endl;
+	static fixed_string::fixed_string<64> fs;
+	static fixed_string::fixed_string<64> other("the quick brown fox jumps over the lazy dog, twice");
+	static const char text[] = "the quick brown fox jumps over the lazy dog, twice";
+	const int len = sizeof(text) - 1;
+	const long iterations = 1000000;
+	measure_counters("append(char), 50 times", iterations, len, [&]() {
+		fs = "";
+		for (int i = 0; i < len; i++)
+			fs.append(text[i]);
+		sink = fs.get_used_length();
+	});
+	measure_counters("append(s, 50)", iterations, len, [&]() {
+		fs = "";
+		fs.append(text, len);
+		sink = fs.get_used_length();
+	});
+	measure_counters("+= char *, 5 times", iterations, 25, [&]() {
+		fs = "";
+		for (int i = 0; i < 5; i++)
+			fs += "field";
+		sink = fs.get_used_length();
+	});
+	fs = other;
+	measure_counters("operator==, equal", iterations, len, [&]() {
+		sink = fs == other;
+	});
+	const char * volatile pointer = text;
+	measure_counters("operator==, char *", iterations, len, [&]() {
+		sink = other == static_cast<const char *>(pointer);
+	});
+	measure_counters("to_lower_into", iterations, len, [&]() {
+		other.to_lower_into(fs);
+		sink = fs.get_used_length();
+	});
+	measure_counters("hash", iterations, len, [&]() {
+		sink = other.hash();
+	});
+	measure_counters("append_json_escaped", iterations, len, [&]() {
+		fs = "";
+		fs.append_json_escaped(text, len);
+		sink = fs.get_used_length();
+	});
+}
+
+//! Without arguments every benchmark runs; "counters" runs only the
+//! hardware counter report, "latency [json] [threads]" only the tail
+//! latency one, as JSON lines with json, on up to threads threads
+int main(int argc, char ** argv) {
+	if (argc > 1 && std::strcmp(argv[1], "counters") == 0) {
+		benchmark_counters();
+		return 0;
+	}
+	if (argc > 1 && std::strcmp(argv[1], "latency") == 0) {
+		bool json = false;
+		int threads = 8;
+		for (int a = 2; a < argc; a++)
+			if (std::strcmp(argv[a], "json") == 0)
+				json = true;
+			else
+				threads = std::atoi(argv[a]);
+		benchmark_tail_latency(threads > 0 ? threads : 1, 200000, json);
+		return 0;
+	}
+	benchmark_counters();
+	benchmark_append();
+	benchmark_literals();
+	benchmark_std_string();
+	benchmark_glob();
+	benchmark_multi_pattern();
+	benchmark_keyword_switch();
+	benchmark_batch_scaling();
+	benchmark_serialization();
+	benchmark_escaping();
+	benchmark_hybrid();
+	benchmark_hashed_keys();
+	benchmark_trie();
+	benchmark_sorted_set();
+	benchmark_bloom();
+	benchmark_normalize();
+	benchmark_hex_base64();
+	benchmark_timestamp();
+	benchmark_logger();
+	benchmark_tail_latency(4, 100000, false);
+	return 0;
+}
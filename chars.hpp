@@ -0,0 +1,206 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * chars.hpp
+ *
+ *  Character classes and the kernels behind the trim, case
+ *  conversion, remove_if and all_of members of fixed_string. The
+ *  classes are those of the "C" locale, looked up in one table of
+ *  256 entries; bytes from 0x80 up belong to no class. Case
+ *  conversion and the whitespace scans of trim take 16 bytes at a
+ *  time with SSE2 where available.
+ */
+
+#ifndef CHARS_HPP_
+#define CHARS_HPP_
+
+#include <stdint.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace fixed_string {
+namespace chars {
+
+//! character classes; combine them with |
+enum char_class {
+	space = 1,		//!< ' ', '\t', '\n', '\v', '\f', '\r'
+	digit = 2,		//!< '0' .. '9'
+	lower = 4,		//!< 'a' .. 'z'
+	upper = 8,		//!< 'A' .. 'Z'
+	punct = 16,		//!< printable, not alphanumeric or ' '
+	control = 32,	//!< 0x00 .. 0x1F and 0x7F
+	xdigit = 64,	//!< '0' .. '9', 'a' .. 'f', 'A' .. 'F'
+	print = 128,	//!< 0x20 .. 0x7E
+	alpha = lower | upper,
+	alnum = alpha | digit
+};
+
+inline char_class operator|(char_class a, char_class b) {
+	return char_class(int(a) | int(b));
+}
+
+//! the classes of every byte
+inline const uint8_t * table() {
+	struct classes {
+		uint8_t c[256];
+		classes() {
+			for (int i = 0; i < 256; i++) {
+				uint8_t m = 0;
+				if (i == ' ' || (i >= '\t' && i <= '\r'))
+					m |= space;
+				if (i >= '0' && i <= '9')
+					m |= digit | xdigit;
+				if (i >= 'a' && i <= 'z')
+					m |= lower;
+				if (i >= 'A' && i <= 'Z')
+					m |= upper;
+				if ((i >= 'a' && i <= 'f') || (i >= 'A' && i <= 'F'))
+					m |= xdigit;
+				if (i < 0x20 || i == 0x7F)
+					m |= control;
+				if (i >= 0x20 && i < 0x7F) {
+					m |= print;
+					if (i != ' ' && !(m & (digit | lower | upper)))
+						m |= punct;
+				}
+				c[i] = m;
+			}
+		}
+	};
+	static const classes t;
+	return t.c;
+}
+
+//! true if c is in one of the classes of cls
+inline bool is(char c, char_class cls) {
+	return (table()[static_cast<unsigned char>(c)] & cls) != 0;
+}
+
+#if defined(__SSE2__)
+//! all ones for the bytes of x in [lo, lo + n), n < 128
+inline __m128i in_range(__m128i x, char lo, int n) {
+	// shift the range to the bottom of the signed bytes
+	const __m128i shifted = _mm_add_epi8(x, _mm_set1_epi8(char(-128 - lo)));
+	return _mm_cmplt_epi8(shifted, _mm_set1_epi8(char(-128 + n)));
+}
+
+//! all ones for the whitespace bytes of x
+inline __m128i is_space(__m128i x) {
+	return _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), in_range(x, '\t', 5));
+}
+#endif
+
+//! Writes in[0 .. len) to out with the letters of the range
+//! [first, first + 26) moved by delta (in may be out)
+inline void shift_letters(const char * in, int len, char * out, char first, char delta) {
+	int i = 0;
+#if defined(__SSE2__)
+	const __m128i d = _mm_set1_epi8(delta);
+	for (; i + 16 <= len; i += 16) {
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+		const __m128i letter = in_range(x, first, 26);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_add_epi8(x, _mm_and_si128(letter, d)));
+	}
+#endif
+	for (; i < len; i++)
+		out[i] = char(in[i] + ((unsigned char) (in[i] - first) < 26 ? delta : 0));
+}
+
+inline void to_lower(const char * in, int len, char * out) {
+	shift_letters(in, len, out, 'A', 'a' - 'A');
+}
+
+inline void to_upper(const char * in, int len, char * out) {
+	shift_letters(in, len, out, 'a', 'A' - 'a');
+}
+
+//! number of whitespace characters at the start of s[0 .. len)
+inline int leading_space(const char * s, int len) {
+	int i = 0;
+#if defined(__SSE2__)
+	for (; i + 16 <= len; i += 16) {
+		const int mask = _mm_movemask_epi8(is_space(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i))));
+		if (mask != 0xFFFF)
+			return i + __builtin_ctz(~mask);
+	}
+#endif
+	while (i < len && is(s[i], space))
+		i++;
+	return i;
+}
+
+//! number of whitespace characters at the end of s[0 .. len)
+inline int trailing_space(const char * s, int len) {
+	int i = len;
+#if defined(__SSE2__)
+	for (; i >= 16; i -= 16) {
+		const int mask = _mm_movemask_epi8(is_space(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i - 16))));
+		if (mask != 0xFFFF)
+			// the highest byte that is not whitespace
+			return len - (i - 16) - (32 - __builtin_clz(~mask & 0xFFFF));
+	}
+#endif
+	while (i > 0 && is(s[i - 1], space))
+		i--;
+	return len - i;
+}
+
+//! Copies the characters of in[0 .. len) that are not in cls to
+//! out (which may be in), at most max of them, and returns how
+//! many. read is set to the number of characters of in looked at.
+//! Branch free: every character is stored, but the output only
+//! advances past those that are kept.
+inline int remove_class(const char * in, int len, char * out, int max, char_class cls, int & read) {
+	const uint8_t * t = table();
+	int n = 0;
+	int i = 0;
+	for (; i < len && n < max; i++) {
+		const char c = in[i];
+		out[n] = c;
+		n += (t[static_cast<unsigned char>(c)] & cls) == 0;
+	}
+	read = i;
+	return n;
+}
+
+//! true if every character of s[0 .. len) is in cls
+inline bool all_of(const char * s, int len, char_class cls) {
+	const uint8_t * t = table();
+	int i = 0;
+	// test a block at a time, without a branch per character
+	for (; i + 16 <= len; i += 16) {
+		int ok = cls;
+		for (int j = 0; j < 16; j++)
+			ok &= -((t[static_cast<unsigned char>(s[i + j])] & cls) != 0);
+		if (!ok)
+			return false;
+	}
+	for (; i < len; i++)
+		if (!(t[static_cast<unsigned char>(s[i])] & cls))
+			return false;
+	return true;
+}
+
+} // namespace chars
+} // namespace fixed_string
+#endif /* CHARS_HPP_ */
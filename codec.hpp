@@ -0,0 +1,216 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * codec.hpp
+ *
+ *  Hex and base64 conversion kernels for fixed_string. The output
+ *  size of all four conversions is known from the input size, so the
+ *  callers check for room once and the kernels write without checks.
+ *  Hex is converted 16 bytes at a time with SSE2 where available;
+ *  base64 goes through lookup tables, one group of 3 bytes (4
+ *  characters) per step, with the validity of the input checked
+ *  once at the end.
+ */
+
+#ifndef CODEC_HPP_
+#define CODEC_HPP_
+
+#include <stdint.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace fixed_string {
+namespace codec {
+
+//! number of base64 characters for len bytes (padded)
+inline int base64_size(int len) {
+	return (len + 2) / 3 * 4;
+}
+
+//! value of a hex digit, or -1
+inline int hex_digit(unsigned char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	c |= 0x20;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+#if defined(__SSE2__)
+//! the 16 nibbles in n (0 .. 15) as lowercase hex digits
+inline __m128i hex_digits(__m128i n) {
+	const __m128i letter = _mm_cmpgt_epi8(n, _mm_set1_epi8(9));
+	return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')),
+			_mm_and_si128(letter, _mm_set1_epi8('a' - '0' - 10)));
+}
+
+//! the 16 hex digits in c as nibbles; valid is set to all
+//! ones for the bytes that are hex digits
+inline __m128i hex_nibbles(__m128i c, __m128i & valid) {
+	const __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+	const __m128i l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+	// signed range checks: anything outside wrapped to negative
+	const __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(d, _mm_set1_epi8(-1)),
+			_mm_cmplt_epi8(d, _mm_set1_epi8(10)));
+	const __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8(-1)),
+			_mm_cmplt_epi8(l, _mm_set1_epi8(6)));
+	valid = _mm_or_si128(is_digit, is_letter);
+	return _mm_or_si128(_mm_and_si128(is_digit, d),
+			_mm_and_si128(is_letter, _mm_add_epi8(l, _mm_set1_epi8(10))));
+}
+
+//! two bytes per 16 bit lane, high nibble first, into one byte
+inline __m128i hex_pairs(__m128i n) {
+	return _mm_and_si128(_mm_or_si128(_mm_slli_epi16(n, 4), _mm_srli_epi16(n, 8)),
+			_mm_set1_epi16(0x00FF));
+}
+#endif
+
+//! Writes the 2 * len lowercase hex digits of in[0 .. len) to out
+inline void hex_encode(const unsigned char * in, int len, char * out) {
+	static const char digits[] = "0123456789abcdef";
+	int i = 0;
+#if defined(__SSE2__)
+	const __m128i low = _mm_set1_epi8(0x0F);
+	for (; i + 16 <= len; i += 16) {
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+		const __m128i hi = hex_digits(_mm_and_si128(_mm_srli_epi16(x, 4), low));
+		const __m128i lo = hex_digits(_mm_and_si128(x, low));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+	}
+#endif
+	for (; i < len; i++) {
+		out[2 * i] = digits[in[i] >> 4];
+		out[2 * i + 1] = digits[in[i] & 0x0F];
+	}
+}
+
+//! Decodes the len (even) hex digits of in to len / 2 bytes at
+//! out; upper and lower case are accepted. Returns false if in
+//! holds anything else; out is then partly written.
+inline bool hex_decode(const char * in, int len, unsigned char * out) {
+	int i = 0;
+#if defined(__SSE2__)
+	for (; i + 32 <= len; i += 32) {
+		__m128i valid_a, valid_b;
+		const __m128i a = hex_nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)), valid_a);
+		const __m128i b = hex_nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 16)), valid_b);
+		if (_mm_movemask_epi8(_mm_and_si128(valid_a, valid_b)) != 0xFFFF)
+			return false;
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i / 2),
+				_mm_packus_epi16(hex_pairs(a), hex_pairs(b)));
+	}
+#endif
+	for (; i < len; i += 2) {
+		const int hi = hex_digit(in[i]);
+		const int lo = hex_digit(in[i + 1]);
+		if ((hi | lo) < 0)
+			return false;
+		out[i / 2] = (hi << 4) | lo;
+	}
+	return true;
+}
+
+//! the base64 alphabet (RFC 4648)
+inline const char * base64_alphabet() {
+	return "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+}
+
+//! value of every character in base64, or -1
+inline const int8_t * base64_values() {
+	struct table {
+		int8_t v[256];
+		table() {
+			for (int i = 0; i < 256; i++)
+				v[i] = -1;
+			for (int i = 0; i < 64; i++)
+				v[static_cast<unsigned char>(base64_alphabet()[i])] = i;
+		}
+	};
+	static const table t;
+	return t.v;
+}
+
+//! Writes base64_size(len) characters for in[0 .. len) to out,
+//! padded with '='
+inline void base64_encode(const unsigned char * in, int len, char * out) {
+	const char * a = base64_alphabet();
+	int i = 0;
+	for (; i + 3 <= len; i += 3, out += 4) {
+		const uint32_t v = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) | in[i + 2];
+		out[0] = a[v >> 18];
+		out[1] = a[(v >> 12) & 63];
+		out[2] = a[(v >> 6) & 63];
+		out[3] = a[v & 63];
+	}
+	if (i < len) {
+		const uint32_t v = (uint32_t(in[i]) << 16) | (i + 1 < len ? uint32_t(in[i + 1]) << 8 : 0);
+		out[0] = a[v >> 18];
+		out[1] = a[(v >> 12) & 63];
+		out[2] = i + 1 < len ? a[(v >> 6) & 63] : '=';
+		out[3] = '=';
+	}
+}
+
+//! Decodes the padded base64 text in[0 .. len) to out and returns
+//! the number of bytes, or -1 if in is not valid base64. At most
+//! len / 4 * 3 bytes are written.
+inline int base64_decode(const char * in, int len, unsigned char * out) {
+	if (len % 4 != 0)
+		return -1;
+	if (len == 0)
+		return 0;
+	const int8_t * v = base64_values();
+	const unsigned char * p = reinterpret_cast<const unsigned char *>(in);
+	// the last group may hold padding, decode the others in a loop
+	const int groups = len / 4 - 1;
+	int bad = 0;
+	for (int g = 0; g < groups; g++, p += 4, out += 3) {
+		const int a = v[p[0]], b = v[p[1]], c = v[p[2]], d = v[p[3]];
+		bad |= a | b | c | d;
+		const uint32_t x = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | uint32_t(d);
+		out[0] = x >> 16;
+		out[1] = x >> 8;
+		out[2] = x;
+	}
+	const int pad = (p[3] == '=') + (p[2] == '=' && p[3] == '=');
+	const int a = v[p[0]], b = v[p[1]];
+	const int c = pad == 2 ? 0 : v[p[2]];
+	const int d = pad >= 1 ? 0 : v[p[3]];
+	bad |= a | b | c | d;
+	if (bad < 0)
+		return -1;
+	const uint32_t x = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | uint32_t(d);
+	out[0] = x >> 16;
+	if (pad < 2)
+		out[1] = x >> 8;
+	if (pad < 1)
+		out[2] = x;
+	return groups * 3 + 3 - pad;
+}
+
+} // namespace codec
+} // namespace fixed_string
+#endif /* CODEC_HPP_ */
@@ -0,0 +1,83 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * codesize.cpp
+ *
+ *  Code-size probe: every function below performs one fixed_string
+ *  operation for one pair of lengths and is kept out of line, so
+ *  the size of its symbol is the machinecode that operation costs.
+ *  Build the codesize target to get the report:
+ *   - the .text size of the whole probe
+ *   - the size of every probe and every out-of-line fixed_string
+ *     function, smallest first
+ *  If an operation grows, or an instantiation per length shows up
+ *  again, it is visible here before it is on the device.
+ */
+
+#include "fixed_string.hpp"
+
+#define NOINLINE __attribute__((noinline))
+
+namespace codesize {
+
+//! One probe of every operation for the lengths N and M
+#define CODESIZE_PROBES(N, M) \
+	NOINLINE void construct_##N##_from_##M(const fixed_string::fixed_string<M> & rhs) { \
+		fixed_string::fixed_string<N> fs(rhs); \
+		asm volatile("" : : "r"(fs.c_str()) : "memory"); \
+	} \
+	NOINLINE void assign_##N##_from_##M(fixed_string::fixed_string<N> & lhs, \
+			const fixed_string::fixed_string<M> & rhs) { \
+		lhs = rhs; \
+	} \
+	NOINLINE void append_##N##_from_##M(fixed_string::fixed_string<N> & lhs, \
+			const fixed_string::fixed_string<M> & rhs) { \
+		lhs += rhs; \
+	} \
+	NOINLINE bool compare_##N##_with_##M(const fixed_string::fixed_string<N> & lhs, \
+			const fixed_string::fixed_string<M> & rhs) { \
+		return lhs == rhs; \
+	}
+
+CODESIZE_PROBES(8, 16)
+CODESIZE_PROBES(16, 8)
+CODESIZE_PROBES(16, 16)
+CODESIZE_PROBES(32, 64)
+CODESIZE_PROBES(64, 32)
+CODESIZE_PROBES(128, 256)
+
+//! Operations on a single length
+#define CODESIZE_SINGLE(N) \
+	NOINLINE void assign_char_array_##N(fixed_string::fixed_string<N> & lhs, const char * rhs) { \
+		lhs = rhs; \
+	} \
+	NOINLINE void append_char_##N(fixed_string::fixed_string<N> & lhs, char rhs) { \
+		lhs += rhs; \
+	} \
+	NOINLINE void insert_##N(fixed_string::fixed_string<N> & lhs, const char * rhs) { \
+		lhs.insert(0, rhs); \
+	}
+
+CODESIZE_SINGLE(8)
+CODESIZE_SINGLE(64)
+
+} // namespace codesize
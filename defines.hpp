@@ -34,4 +34,23 @@
 
 #define OPTIMIZEFORSPEED
 
+//! When a string runs out of room, cut it at the last complete
+//! UTF-8 code point instead of in the middle of a sequence.
+//! Costs a look at the cut on every truncation, so it is off
+//! unless defined by the build (runTestsUtf8 does).
+//#define UTF8SAFETRUNCATION
+
+//! Leave the null-terminator out when appending a single
+//! character: only the length is updated, and c_str() writes
+//! the terminator when it is asked for. Operations that write
+//! several characters still end with one. Needs OPTIMIZEFORSPEED.
+//! Off unless defined by the build (runTestsDeferred does).
+//#define DEFERREDTERMINATOR
+
+//! Count truncations, discarded characters and the longest used
+//! length per allocated length (see fixed_string_statistics.hpp).
+//! Costs a thread-local table lookup on every change of length,
+//! so it is off unless defined by the build (as the tests do).
+//#define FIXEDSTRINGSTATISTICS
+
 #endif /* DEFINES_HPP_ */
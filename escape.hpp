@@ -0,0 +1,229 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * escape.hpp
+ *
+ *  Scanning helpers for the JSON and CSV escaping of fixed_string.
+ *  They find the next character that needs treatment 16 bytes at a
+ *  time with SSE2 where available, else 8 bytes at a time, so runs of
+ *  clean characters can be copied in bulk.
+ */
+
+#ifndef ESCAPE_HPP_
+#define ESCAPE_HPP_
+
+#include <cstring>
+#include <stdint.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace fixed_string {
+namespace escape {
+
+//! true for the characters JSON requires to be escaped
+inline bool is_json_special(unsigned char c) {
+	return c < 0x20 || c == '"' || c == '\\';
+}
+
+//! true for the characters that force a CSV field to be quoted
+inline bool is_csv_special(unsigned char c) {
+	return c == ',' || c == '"' || c == '\r' || c == '\n';
+}
+
+//! word with every byte set to c
+inline uint64_t broadcast(unsigned char c) {
+	return 0x0101010101010101ULL * c;
+}
+
+//! non-zero if any byte of w equals zero (may flag extra
+//! bytes after the first zero byte, never misses one)
+inline uint64_t has_zero(uint64_t w) {
+	return (w - 0x0101010101010101ULL) & ~w & 0x8080808080808080ULL;
+}
+
+//! non-zero if any byte of w is below 0x20
+inline uint64_t has_control(uint64_t w) {
+	return (w - broadcast(0x20)) & ~w & 0x8080808080808080ULL;
+}
+
+//! GCC attribute that keeps the bulk scans out of line: inlined into
+//! a caller with a short literal, their loads would be flagged by
+//! -Warray-bounds even though the length rules them out
+#if defined(__GNUC__)
+#define FIXED_STRING_ESCAPE_OUT_OF_LINE __attribute__((noinline))
+#else
+#define FIXED_STRING_ESCAPE_OUT_OF_LINE
+#endif
+
+//! Bulk part of find_json_special(): skips the blocks of 16 (SSE2)
+//! and 8 bytes without a special character, returns where it stopped
+FIXED_STRING_ESCAPE_OUT_OF_LINE inline int skip_json_plain(const char * s, int len) {
+	int i = 0;
+#if defined(__SSE2__)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i control = _mm_set1_epi8(0x1F);
+	for (; i + 16 <= len; i += 16) {
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+		// unsigned x <= 0x1F  <=>  max(x, 0x1F) == 0x1F
+		const __m128i special = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)),
+				_mm_cmpeq_epi8(_mm_max_epu8(x, control), control));
+		const int mask = _mm_movemask_epi8(special);
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+#endif
+	for (; i + 8 <= len; i += 8) {
+		uint64_t w;
+		std::memcpy(&w, s + i, 8);
+		if (has_zero(w ^ broadcast('"')) | has_zero(w ^ broadcast('\\')) | has_control(w))
+			break;
+	}
+	return i;
+}
+
+//! Returns the position of the first character in [s, s + len) for
+//! which is_json_special() holds, or len
+inline int find_json_special(const char * s, int len) {
+	int i = len >= 8 ? skip_json_plain(s, len) : 0;
+	for (; i < len; i++)
+		if (is_json_special(s[i]))
+			return i;
+	return len;
+}
+
+//! Bulk part of find_csv_special(), see skip_json_plain()
+FIXED_STRING_ESCAPE_OUT_OF_LINE inline int skip_csv_plain(const char * s, int len) {
+	int i = 0;
+#if defined(__SSE2__)
+	const __m128i comma = _mm_set1_epi8(',');
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i lf = _mm_set1_epi8('\n');
+	for (; i + 16 <= len; i += 16) {
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+		const __m128i special = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(x, comma), _mm_cmpeq_epi8(x, quote)),
+				_mm_or_si128(_mm_cmpeq_epi8(x, cr), _mm_cmpeq_epi8(x, lf)));
+		const int mask = _mm_movemask_epi8(special);
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+#endif
+	for (; i + 8 <= len; i += 8) {
+		uint64_t w;
+		std::memcpy(&w, s + i, 8);
+		if (has_zero(w ^ broadcast(',')) | has_zero(w ^ broadcast('"'))
+				| has_zero(w ^ broadcast('\r')) | has_zero(w ^ broadcast('\n')))
+			break;
+	}
+	return i;
+}
+
+//! Returns the position of the first character in [s, s + len) for
+//! which is_csv_special() holds, or len
+inline int find_csv_special(const char * s, int len) {
+	int i = len >= 8 ? skip_csv_plain(s, len) : 0;
+	for (; i < len; i++)
+		if (is_csv_special(s[i]))
+			return i;
+	return len;
+}
+
+//! Writes the JSON escape sequence of c (a character for which
+//! is_json_special() holds) to out and returns its length (2 or 6)
+inline int json_escape(unsigned char c, char * out) {
+	static const char hex[] = "0123456789abcdef";
+	out[0] = '\\';
+	switch (c) {
+	case '"':  out[1] = '"'; return 2;
+	case '\\': out[1] = '\\'; return 2;
+	case '\b': out[1] = 'b'; return 2;
+	case '\f': out[1] = 'f'; return 2;
+	case '\n': out[1] = 'n'; return 2;
+	case '\r': out[1] = 'r'; return 2;
+	case '\t': out[1] = 't'; return 2;
+	default:
+		out[1] = 'u';
+		out[2] = '0';
+		out[3] = '0';
+		out[4] = hex[c >> 4];
+		out[5] = hex[c & 0xF];
+		return 6;
+	}
+}
+
+//! value of a hexadecimal digit, or -1
+inline int hex_value(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+//! reads 4 hexadecimal digits, returns -1 if they are not
+inline long read_hex4(const char * s) {
+	long v = 0;
+	for (int i = 0; i < 4; i++) {
+		const int d = hex_value(s[i]);
+		if (d < 0)
+			return -1;
+		v = (v << 4) | d;
+	}
+	return v;
+}
+
+//! writes code point cp as UTF-8 to out, returns the length
+inline int encode_utf8(unsigned long cp, char * out) {
+	if (cp < 0x80) {
+		out[0] = cp;
+		return 1;
+	}
+	if (cp < 0x800) {
+		out[0] = 0xC0 | (cp >> 6);
+		out[1] = 0x80 | (cp & 0x3F);
+		return 2;
+	}
+	if (cp < 0x10000) {
+		out[0] = 0xE0 | (cp >> 12);
+		out[1] = 0x80 | ((cp >> 6) & 0x3F);
+		out[2] = 0x80 | (cp & 0x3F);
+		return 3;
+	}
+	out[0] = 0xF0 | (cp >> 18);
+	out[1] = 0x80 | ((cp >> 12) & 0x3F);
+	out[2] = 0x80 | ((cp >> 6) & 0x3F);
+	out[3] = 0x80 | (cp & 0x3F);
+	return 4;
+}
+
+} // namespace escape
+} // namespace fixed_string
+
+#undef FIXED_STRING_ESCAPE_OUT_OF_LINE
+
+#endif /* ESCAPE_HPP_ */
@@ -48,19 +48,61 @@
 #ifndef _FIXED_STRING_H_
 #define _FIXED_STRING_H_
 
+#include <algorithm>
 #include <iostream>
 #include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 #include "defines.hpp"
+#include "utf8.hpp"
+#include "escape.hpp"
+#include "codec.hpp"
+#include "chars.hpp"
+#if defined(FIXEDSTRINGSTATISTICS)
+#include "fixed_string_statistics.hpp"
+#endif
 #if defined(CANTHROWSTDEXCEPTIONS)
 #include <stdexcept>
 #endif
+#if defined(DEFERREDTERMINATOR) && !defined(OPTIMIZEFORSPEED)
+#error "DEFERREDTERMINATOR needs the length kept by OPTIMIZEFORSPEED"
+#endif
 
 namespace fixed_string {
 
 //! forward declaration to use class in subclass iter
 template<int N> class fixed_string;
 
+//! enable_if for the templated operators of fixed_string<0>:
+//! fixed_strings of every length are handled by non-template
+//! overloads instead, so no code is generated per length.
+template<typename T, typename R>
+struct if_not_fixed_string: std::enable_if<
+		!std::is_base_of<fixed_string<0>, T>::value, R> {
+};
+
+//! enable_if for the overloads taking a char array, C being
+//! char or const char: string literals among them, whose
+//! length is known at compile time
+template<typename C, typename R>
+struct if_char: std::enable_if<
+		std::is_same<typename std::remove_const<C>::type, char>::value, R> {
+};
+
+//! enable_if for a char * or const char * taken by value, P
+//! being deduced as a pointer from an array as well
+template<typename P, typename R>
+struct if_char_pointer: std::enable_if<std::is_pointer<P>::value
+		&& std::is_same<typename std::remove_const<typename std::remove_pointer<P>::type>::type, char>::value, R> {
+};
+
 //! @brief implementation containing all functions
 //! @details
 //! Usage: none - all functions are inherited by fixed_string<N>
@@ -86,6 +128,29 @@ template<int N> class fixed_string;
 //! <li> get_allocated_length()
 //! <li> get_used_length()
 //! <li> append()
+//! <li> in-place editing
+//!		- insert()
+//!		- erase()
+//!		- replace()
+//!		- replace_all()
+//!		- truncate()
+//!		- resize()
+//! <li> normalizing
+//!		- trim(), ltrim(), rtrim()
+//!		- to_lower(), to_upper()
+//!		- remove_if(), all_of()
+//!		- trim_into(), to_lower_into(), to_upper_into(), remove_if_into()
+//! <li> hex and base64
+//!		- append_hex(), append_base64()
+//!		- decode_hex_into(), decode_base64_into()
+//! <li> JSON and CSV escaping
+//!		- append_json_escaped(), append_json_unescaped()
+//!		- append_csv_quoted(), append_csv_unquoted()
+//! <li> hash()
+//! <li> UTF-8 helpers
+//!		- is_valid_utf8()
+//!		- codepoint_count()
+//!		- codepoints()
 //! <li> various comparison operators
 //!		- operator==
 //!		- operator!=
@@ -148,8 +213,8 @@ protected:
 				c(ch), start(&c), last(&this->c + 1) {
 		}
 		//! constructor for fixed_string< 0 >
-		iter(fixed_string<0> f) :
-				start(f.c_str()), last(f.c_str() + std::strlen(f.c_str())) {
+		iter(const fixed_string<0> & f) :
+				start(f.begin()), last(f.end()) {
 
 		}
 
@@ -170,6 +235,50 @@ protected:
 
 	};
 
+public:
+	//! class codepoint_range provides for-loop integration over the
+	//! code points of a fixed_string, decoded from UTF-8:
+	//! \code for( char32_t cp : some_fixed_string.codepoints() ) { \endcode
+	//! Invalid bytes are returned as U+FFFD, one per byte.
+	class codepoint_range {
+	public:
+		class iterator {
+		public:
+			iterator(const char * p, const char * last) :
+					p(p), last(last) {
+			}
+			char32_t operator*() const {
+				int n;
+				return utf8::decode(p, last - p, n);
+			}
+			iterator & operator++() {
+				int n;
+				utf8::decode(p, last - p, n);
+				p += n;
+				return *this;
+			}
+			bool operator!=(const iterator & rhs) const {
+				return p != rhs.p;
+			}
+		private:
+			const char *p, *last;
+		};
+
+		codepoint_range(const char * start, const char * last) :
+				start(start), last(last) {
+		}
+		iterator begin() const {
+			return iterator(start, last);
+		}
+		iterator end() const {
+			return iterator(last, last);
+		}
+
+	private:
+		const char *start, *last;
+	};
+
+protected:
 	//! The inherited fixed_strings will always call this constructor
 	//! Protected constructor, never allow a fixed_string< 0 > to be
 	//! initialized solely without fixed_string< N >
@@ -186,7 +295,14 @@ public:
 	//! Returns a pointer to the contents of a fixed_string.
 	//! It does not allow any changes, hence this is a
 	//! read-only function.
+	//! If DEFERREDTERMINATOR is defined, this is where the
+	//! null-terminator left out by append(char) is written:
+	//! c_str() then stores to the buffer, so threads sharing a
+	//! const fixed_string must not call it concurrently.
 	const char * c_str() const {
+#if defined(DEFERREDTERMINATOR)
+		pBuff[used_length] = '\0';
+#endif
 		return pBuff;
 	}
 
@@ -222,7 +338,12 @@ public:
 		if (valid(used_length)) {
 			// stringlen points to position of the last '\0'
 			pBuff[used_length++] = c;
+#if !defined(DEFERREDTERMINATOR)
 			pBuff[used_length] = '\0';
+#endif
+#if defined(FIXEDSTRINGSTATISTICS)
+			statistics::record_length(allocated_length, used_length);
+#endif
 		}
 #else
 		int i;
@@ -237,21 +358,597 @@ public:
 #endif
 
 		else {
-			// in template class meegeven voor al dan niet afhandelen van exceptions
-			/*std::cout << "USE_ERROR_CHAR " << std::endl;*/
-			// error char deprecated
-			error_char = '?';
-#if defined(CANTHROWSTDEXCEPTIONS)
-			throw std::out_of_range("out of range");
+			cut(get_used_length(), get_used_length() + 1);
+		}
+	}
+
+	//! Appends len characters starting at s, as far as the
+	//! allocated length allows. The characters that fit are
+	//! copied in one go; when the string runs out of room the
+	//! same error handling as append(char) applies.
+	//! If UTF8SAFETRUNCATION is defined, a truncated string
+	//! is shortened to the last complete code point.
+	void append(const char * s, int len) {
+		const int used = get_used_length();
+		const int room = allocated_length - 1 - used;
+		// never more than len, which bounds the read of s
+		const int fits = len < room ? len : room;
+		// memmove, as s may point into our own buffer
+		std::memmove(pBuff + used, s, fits);
+		if (len <= room) {
+			set_length(used + len);
+			return;
+		}
+		cut(used + fits, used + len);
+	}
+
+	//! Replaces the string by the len characters starting at s,
+	//! with the same truncation rules as append(const char *, int)
+	void assign(const char * s, int len) {
+		reset();
+		append(s, len);
+	}
+
+	//! Returns the number of characters [s, s + len) takes once
+	//! escaped for a JSON string (without the surrounding quotes),
+	//! so callers can pick a large enough fixed_string
+	static int json_escaped_size(const char * s, int len) {
+		int size = len;
+		char e[6];
+		for (int i = escape::find_json_special(s, len); i < len;
+				i += 1 + escape::find_json_special(s + i + 1, len - i - 1))
+			size += escape::json_escape(s[i], e) - 1;
+		return size;
+	}
+
+	//! Appends [s, s + len) escaped for a JSON string (without the
+	//! surrounding quotes). Runs of characters that need no escape
+	//! are found 16 or 8 bytes at a time and copied in bulk. An
+	//! escape sequence is never cut in half: if it does not fit,
+	//! the string ends before it.
+	void append_json_escaped(const char * s, int len) {
+		int i = 0;
+		while (i < len) {
+			const int run = escape::find_json_special(s + i, len - i);
+			if (!append_part(s + i, run))
+				return;
+			i += run;
+			if (i == len)
+				return;
+			char e[6];
+			if (!append_whole(e, escape::json_escape(s[i], e)))
+				return;
+			i++;
+		}
+	}
+
+	//! Appends rhs (char, char *, fixed_string) escaped for JSON,
+	//! see append_json_escaped(const char *, int)
+	template<typename T>
+	void append_json_escaped(T const & rhs) {
+		iter it(rhs);
+		append_json_escaped(it.begin(), it.end() - it.begin());
+	}
+
+	//! Appends the JSON string contents [s, s + len) (without the
+	//! surrounding quotes) with all escape sequences resolved; \\u
+	//! escapes, including surrogate pairs, are written as UTF-8.
+	//! Returns false if the input is not valid JSON string contents:
+	//! a bad escape, a raw control character or an unescaped '"';
+	//! what was decoded up to the error has been appended.
+	bool append_json_unescaped(const char * s, int len) {
+		int i = 0;
+		while (i < len) {
+			const int run = escape::find_json_special(s + i, len - i);
+			if (!append_part(s + i, run))
+				return true;
+			i += run;
+			if (i == len)
+				return true;
+			if (s[i] != '\\' || i + 1 == len)
+				return false;
+			char c;
+			switch (s[i + 1]) {
+			case '"': c = '"'; break;
+			case '\\': c = '\\'; break;
+			case '/': c = '/'; break;
+			case 'b': c = '\b'; break;
+			case 'f': c = '\f'; break;
+			case 'n': c = '\n'; break;
+			case 'r': c = '\r'; break;
+			case 't': c = '\t'; break;
+			case 'u': {
+				if (i + 6 > len)
+					return false;
+				long cp = escape::read_hex4(s + i + 2);
+				i += 6;
+				if (cp < 0 || (cp >= 0xDC00 && cp <= 0xDFFF))
+					return false;
+				if (cp >= 0xD800 && cp <= 0xDBFF) {
+					// high surrogate, must be followed by a low one
+					if (i + 6 > len || s[i] != '\\' || s[i + 1] != 'u')
+						return false;
+					const long low = escape::read_hex4(s + i + 2);
+					if (low < 0xDC00 || low > 0xDFFF)
+						return false;
+					cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+					i += 6;
+				}
+				char u[4];
+				if (!append_whole(u, escape::encode_utf8(cp, u)))
+					return true;
+				continue;
+			}
+			default:
+				return false;
+			}
+			if (!append_whole(&c, 1))
+				return true;
+			i += 2;
+		}
+		return true;
+	}
+
+	//! Appends JSON string contents given as rhs (char *,
+	//! fixed_string) with the escapes resolved
+	template<typename T>
+	bool append_json_unescaped(T const & rhs) {
+		iter it(rhs);
+		return append_json_unescaped(it.begin(), it.end() - it.begin());
+	}
+
+	//! Returns the number of characters append_csv_quoted()
+	//! needs for [s, s + len)
+	static int csv_quoted_size(const char * s, int len) {
+		if (escape::find_csv_special(s, len) == len)
+			return len;
+		int size = len + 2;
+		for (const char * q = s; (q = static_cast<const char *>(
+				std::memchr(q, '"', s + len - q))) != 0; q++)
+			size++;
+		return size;
+	}
+
+	//! Appends [s, s + len) as a CSV field (RFC 4180): unchanged if
+	//! it contains no ',', '"', CR or LF, else between double quotes
+	//! with every '"' doubled. If the quoted field does not fit, its
+	//! contents are cut but the closing quote is always written.
+	void append_csv_quoted(const char * s, int len) {
+		const int needed = csv_quoted_size(s, len);
+		if (needed == len) {
+			append(s, len);
+			return;
+		}
+		const int used = get_used_length();
+		const int room = allocated_length - 1 - used;
+		char * out = pBuff + used;
+		int o = 0;
+		if (needed <= room) {
+			// copy the runs between the quotes in bulk
+			out[o++] = '"';
+			const char * p = s;
+			const char * last = s + len;
+			for (;;) {
+				const char * q = static_cast<const char *>(std::memchr(p, '"', last - p));
+				const int run = (q ? q + 1 : last) - p;
+				std::memcpy(out + o, p, run);
+				o += run;
+				if (!q)
+					break;
+				out[o++] = '"';
+				p = q + 1;
+			}
+			out[o++] = '"';
+			set_length(used + o);
+			return;
+		}
+		if (room < 2) {
+			cut(used, used + needed);
+			return;
+		}
+		out[o++] = '"';
+		for (int i = 0; i < len; i++) {
+			const int w = (s[i] == '"') ? 2 : 1;
+			if (o + w > room - 1)
+				break;
+			out[o++] = s[i];
+			if (w == 2)
+				out[o++] = '"';
+		}
+#if defined(UTF8SAFETRUNCATION)
+		o = utf8::complete_length(out, o);
 #endif
+		out[o++] = '"';
+		set_length(used + o);
+		overflow(needed - o);
+	}
+
+	//! Appends rhs (char, char *, fixed_string) as a CSV field,
+	//! see append_csv_quoted(const char *, int)
+	template<typename T>
+	void append_csv_quoted(T const & rhs) {
+		iter it(rhs);
+		append_csv_quoted(it.begin(), it.end() - it.begin());
+	}
+
+	//! Appends the value of the CSV field [s, s + len): a quoted
+	//! field loses its quotes and its doubled '"' become single.
+	//! Returns false if a quoted field is malformed.
+	bool append_csv_unquoted(const char * s, int len) {
+		if (len == 0 || s[0] != '"') {
+			append(s, len);
+			return true;
+		}
+		if (len < 2 || s[len - 1] != '"')
+			return false;
+		const char * p = s + 1;
+		const char * last = s + len - 1;
+		while (p < last) {
+			const char * q = static_cast<const char *>(std::memchr(p, '"', last - p));
+			if (!q) {
+				append(p, last - p);
+				return true;
+			}
+			if (q + 1 == last || q[1] != '"')
+				return false;
+			if (!append_part(p, q + 1 - p))
+				return true;
+			p = q + 2;
+		}
+		return true;
+	}
+
+	//! Appends the value of the CSV field rhs (char *, fixed_string)
+	template<typename T>
+	bool append_csv_unquoted(T const & rhs) {
+		iter it(rhs);
+		return append_csv_unquoted(it.begin(), it.end() - it.begin());
+	}
+
+	//! Converts the letters A-Z to a-z, 16 characters at a time
+	//! where SSE2 is available; all other bytes stay as they are
+	void to_lower() {
+		chars::to_lower(pBuff, get_used_length(), pBuff);
+	}
+
+	//! Converts the letters a-z to A-Z, see to_lower()
+	void to_upper() {
+		chars::to_upper(pBuff, get_used_length(), pBuff);
+	}
+
+	//! Writes the string with A-Z converted to a-z to out, without
+	//! an intermediate copy, with the truncation rules of append()
+	void to_lower_into(fixed_string & out) const {
+		if (&out == this)
+			return out.to_lower();
+		const int used = get_used_length();
+		const int n = out.fit(used);
+		chars::to_lower(pBuff, n, out.pBuff);
+		out.finish(n, used);
+	}
+
+	//! Writes the string with a-z converted to A-Z to out
+	void to_upper_into(fixed_string & out) const {
+		if (&out == this)
+			return out.to_upper();
+		const int used = get_used_length();
+		const int n = out.fit(used);
+		chars::to_upper(pBuff, n, out.pBuff);
+		out.finish(n, used);
+	}
+
+	//! Removes the whitespace (" \t\n\v\f\r") at the start
+	void ltrim() {
+		const int used = get_used_length();
+		const int n = chars::leading_space(pBuff, used);
+		if (n > 0) {
+			std::memmove(pBuff, pBuff + n, used - n);
+			set_length(used - n);
+		}
+	}
+
+	//! Removes the whitespace at the end
+	void rtrim() {
+		const int used = get_used_length();
+		const int n = chars::trailing_space(pBuff, used);
+		if (n > 0)
+			set_length(used - n);
+	}
+
+	//! Removes the whitespace at both ends
+	void trim() {
+		rtrim();
+		ltrim();
+	}
+
+	//! Writes the string without the whitespace at both ends to out
+	void trim_into(fixed_string & out) const {
+		if (&out == this)
+			return out.trim();
+		const int used = get_used_length();
+		const int lead = chars::leading_space(pBuff, used);
+		const int len = used - lead - chars::trailing_space(pBuff + lead, used - lead);
+		const int n = out.fit(len);
+		std::memcpy(out.pBuff, pBuff + lead, n);
+		out.finish(n, len);
+	}
+
+	//! Removes every character of the classes cls, e.g.
+	//! remove_if(chars::control) or remove_if(chars::space | chars::punct)
+	void remove_if(chars::char_class cls) {
+		const int used = get_used_length();
+		int read;
+		const int n = chars::remove_class(pBuff, used, pBuff, used, cls, read);
+		if (n < used)
+			set_length(n);
+	}
+
+	//! Writes the string without the characters of the classes
+	//! cls to out
+	void remove_if_into(chars::char_class cls, fixed_string & out) const {
+		if (&out == this)
+			return out.remove_if(cls);
+		const int used = get_used_length();
+		int read;
+		const int n = chars::remove_class(pBuff, used, out.pBuff, out.allocated_length - 1, cls, read);
+		int wanted = n;
+		for (int i = read; i < used; i++)
+			wanted += !chars::is(pBuff[i], cls);
+		out.finish(n, wanted);
+	}
+
+	//! Returns true if every character is in one of the classes
+	//! cls, e.g. all_of(chars::digit); true for an empty string
+	bool all_of(chars::char_class cls) const {
+		return chars::all_of(pBuff, get_used_length(), cls);
+	}
+
+	//! Appends the 2 * len lowercase hex digits of the len bytes at
+	//! bytes. The room is checked up front: if not all digits fit,
+	//! nothing is appended and false is returned, after the usual
+	//! error handling of a string that ran out of room.
+	bool append_hex(const void * bytes, int len) {
+		char * out = make_room(2 * len);
+		if (!out)
+			return false;
+		codec::hex_encode(static_cast<const unsigned char *>(bytes), len, out);
+		return true;
+	}
+
+	//! Appends the len bytes at bytes as padded base64 (RFC 4648),
+	//! with the same up front check as append_hex()
+	bool append_base64(const void * bytes, int len) {
+		char * out = make_room(codec::base64_size(len));
+		if (!out)
+			return false;
+		codec::base64_encode(static_cast<const unsigned char *>(bytes), len, out);
+		return true;
+	}
+
+	//! Decodes the string as hex digits (either case) into out, which
+	//! has room for size bytes. Returns the number of bytes, or -1 if
+	//! out is too small (nothing is written) or the string is not
+	//! hex (out may be partly written).
+	int decode_hex_into(void * out, int size) const {
+		const int used = get_used_length();
+		if (used % 2 != 0 || used / 2 > size)
+			return -1;
+		return codec::hex_decode(pBuff, used, static_cast<unsigned char *>(out)) ? used / 2 : -1;
+	}
+
+	//! Decodes the string as padded base64 into out, which has room
+	//! for size bytes. Returns the number of bytes, or -1 if out is
+	//! too small (nothing is written) or the string is not base64
+	//! (out may be partly written).
+	int decode_base64_into(void * out, int size) const {
+		const int used = get_used_length();
+		if (used % 4 != 0)
+			return -1;
+		const int pad = used == 0 ? 0 : (pBuff[used - 1] == '=') + (pBuff[used - 1] == '=' && pBuff[used - 2] == '=');
+		if (used / 4 * 3 - pad > size)
+			return -1;
+		return codec::base64_decode(pBuff, used, static_cast<unsigned char *>(out));
+	}
+
+	//! Returns true if the stored string is well-formed UTF-8
+	bool is_valid_utf8() const {
+		return utf8::validate(pBuff, get_used_length());
+	}
+
+	//! Returns the number of UTF-8 code points in the string.
+	//! Equal to get_used_length() for plain ASCII.
+	int codepoint_count() const {
+		return utf8::count_codepoints(pBuff, get_used_length());
+	}
+
+	//! Returns a range over the code points of the string,
+	//! for use in range-based 'for' loops
+	codepoint_range codepoints() const {
+		return codepoint_range(pBuff, pBuff + get_used_length());
+	}
+
+	//! Returns a 64 bit hash of the string, see hash(const char *, int)
+	uint64_t hash() const {
+		return hash(pBuff, get_used_length());
+	}
+
+	//! Hashes [s, s + len) eight characters at a time: every word is
+	//! mixed in with a multiply, and a final avalanche spreads the
+	//! bits. Fast, not cryptographic.
+	static uint64_t hash(const char * s, int len) {
+		const uint64_t k = 0x9E3779B97F4A7C15ULL;
+		uint64_t h = len * k;
+		int i = 0;
+		for (; i + 8 <= len; i += 8) {
+			uint64_t w;
+			std::memcpy(&w, s + i, 8);
+			h = (h ^ (w * k)) * 0xBF58476D1CE4E5B9ULL;
+			h ^= h >> 29;
+		}
+		if (i < len) {
+			uint64_t w = 0;
+			std::memcpy(&w, s + i, len - i);
+			h = (h ^ (w * k)) * 0xBF58476D1CE4E5B9ULL;
+		}
+		h ^= h >> 32;
+		h *= 0x94D049BB133111EBULL;
+		h ^= h >> 29;
+		return h;
+	}
+
+	//! Replaces the count characters at pos by the len characters
+	//! starting at s. Characters behind the replaced range are moved
+	//! with a single memmove inside the buffer. Whatever does not fit
+	//! in the allocated length is discarded, with the same error
+	//! handling as append().
+	//! pos and count are clamped to the stored string.
+	//! s may point into this fixed_string (fs.insert(0, fs)).
+	void replace(int pos, int count, const char * s, int len) {
+		const int used = get_used_length();
+		const int max = allocated_length - 1;
+		pos = clamp(pos, used);
+		count = clamp(count, used - pos);
+		const int tail = used - pos - count;
+		// how much of s and of the tail still fits
+		const int keep = (len < max - pos) ? len : max - pos;
+		const int tail_keep = (tail < max - pos - keep) ? tail : max - pos - keep;
+		const uintptr_t p = reinterpret_cast<uintptr_t>(s);
+		const uintptr_t b = reinterpret_cast<uintptr_t>(pBuff);
+		if (keep <= count) {
+			// shrinking: s is read before the tail moves over it
+			std::memmove(pBuff + pos, s, keep);
+			std::memmove(pBuff + pos + keep, pBuff + pos + count, tail_keep);
+		} else if (p >= b && p < b + allocated_length && int(p - b) + keep > pos + count)
+			grow_from_self(pos, count, int(p - b), keep, tail_keep);
+		else {
+			// s lies in front of the tail, or elsewhere
+			std::memmove(pBuff + pos + keep, pBuff + pos + count, tail_keep);
+			std::memmove(pBuff + pos, s, keep);
 		}
+		if (keep == len && tail_keep == tail)
+			set_length(pos + keep + tail_keep);
+		else
+			cut(pos + keep + tail_keep, pos + len + tail);
+	}
+
+	//! Replaces the count characters at pos by rhs (char, char *,
+	//! fixed_string). See replace(int, int, const char *, int).
+	template<typename T>
+	void replace(int pos, int count, T const & rhs) {
+		iter it(rhs);
+		replace(pos, count, it.begin(), it.end() - it.begin());
+	}
+
+	//! Inserts the len characters starting at s before position pos.
+	//! See replace(int, int, const char *, int).
+	void insert(int pos, const char * s, int len) {
+		replace(pos, 0, s, len);
+	}
+
+	//! Inserts rhs (char, char *, fixed_string) before position pos.
+	//! See replace(int, int, const char *, int).
+	template<typename T>
+	void insert(int pos, T const & rhs) {
+		replace(pos, 0, rhs);
+	}
+
+	//! Removes count characters starting at pos. The characters
+	//! behind them are moved forward with a single memmove.
+	void erase(int pos, int count) {
+		replace(pos, count, "", 0);
+	}
+
+	//! Replaces every (non-overlapping) occurrence of from by to and
+	//! returns the number of replacements. When to is not longer than
+	//! from, this is done in a single pass over the buffer; else every
+	//! replacement moves the rest of the string once.
+	//! from must not point into this fixed_string; to may, and then
+	//! stands for the string as it was (fs.replace_all(x, fs)).
+	int replace_all(const char * from, int from_len, const char * to, int to_len) {
+		if (from_len <= 0)
+			return 0;
+		const uintptr_t p = reinterpret_cast<uintptr_t>(to);
+		const uintptr_t b = reinterpret_cast<uintptr_t>(pBuff);
+		// the first replacement changes to, but leaves a copy of it
+		// in front of all later ones
+		const bool own = p >= b && p < b + allocated_length;
+		int replaced = 0;
+		if (to_len > from_len) {
+			for (int pos = find(from, from_len, 0); pos >= 0;
+					pos = find(from, from_len, pos + to_len)) {
+				replace(pos, from_len, to, to_len);
+				if (own)
+					to = pBuff + pos;
+				replaced++;
+			}
+			return replaced;
+		}
+		// shrinking or same length: copy down in one pass,
+		// reading at r and writing at w (w <= r)
+		const int used = get_used_length();
+		int r = 0, w = 0;
+		for (int pos = find(from, from_len, 0); pos >= 0;
+				pos = find(from, from_len, r)) {
+			std::memmove(pBuff + w, pBuff + r, pos - r);
+			w += pos - r;
+			std::memmove(pBuff + w, to, to_len);
+			if (own)
+				to = pBuff + w;
+			w += to_len;
+			r = pos + from_len;
+			replaced++;
+		}
+		std::memmove(pBuff + w, pBuff + r, used - r);
+		set_length(w + used - r);
+		return replaced;
+	}
+
+	//! Replaces every occurrence of from by to (char, char *,
+	//! fixed_string). See replace_all(const char *, int, const char *, int).
+	template<typename T, typename U>
+	int replace_all(T const & from, U const & to) {
+		iter f(from), t(to);
+		return replace_all(f.begin(), f.end() - f.begin(), t.begin(),
+				t.end() - t.begin());
+	}
+
+	//! Shortens the string to n characters. Does nothing if the
+	//! string is not longer than n. If UTF8SAFETRUNCATION is
+	//! defined, the string is cut at the last complete code point.
+	void truncate(int n) {
+		if (n < 0)
+			n = 0;
+		if (n >= get_used_length())
+			return;
+#if defined(UTF8SAFETRUNCATION)
+		set_length(utf8::complete_length(pBuff, n));
+#else
+		set_length(n);
+#endif
+	}
+
+	//! Makes the string n characters long: shortens it like
+	//! truncate(), or pads it with c up to the allocated length.
+	void resize(int n, char c = ' ') {
+		const int used = get_used_length();
+		if (n <= used) {
+			truncate(n);
+			return;
+		}
+		const int max = allocated_length - 1;
+		const int fill = (n < max ? n : max) - used;
+		std::memset(pBuff + used, c, fill);
+		if (n > max)
+			cut(used + fill, n);
+		else
+			set_length(used + fill);
 	}
 
 	//! operator+= appends character to this fixed_string
 	//! but only if append() this allows, which means
 	//! that the allocated memory is larger than the stored
-	//! string
-	template<class T>
+	//! string. Not a template (T could never be deduced),
+	//! so a char takes the single character append(char).
 	fixed_string & operator+=(const char ch) {
 		append(ch);
 		return *this;
@@ -262,18 +959,49 @@ public:
 	//! that the allocated memory is larger than the stored
 	//! string
 	template<class T>
-	fixed_string & operator+=(T input) {
-		for (char ch : iter(input))
-			append(ch);
+	typename if_not_fixed_string<T, fixed_string &>::type operator+=(T input) {
+		iter it(input);
+		append(it.begin(), it.end() - it.begin());
+		return *this;
+	}
+
+	//! operator+= appends a char array: a string literal
+	//! or a buffer, measured by array_length()
+	template<typename C, int K>
+	typename if_char<C, fixed_string &>::type operator+=(C (&rhs)[K]) {
+		append(rhs, array_length(rhs));
+		return *this;
+	}
+
+	//! operator+= appends a fixed_string of any length.
+	//! Not a template, so appending fixed_strings of many
+	//! different lengths does not multiply the machinecode.
+	fixed_string & operator+=(const fixed_string & rhs) {
+		append(rhs.c_str(), rhs.get_used_length());
+		return *this;
+	}
+
+	//! operator+= appends a std::string, using its size()
+	//! rather than a strlen() of its c_str()
+	fixed_string & operator+=(const std::string & rhs) {
+		append(rhs.data(), rhs.size());
 		return *this;
 	}
 
+#if __cplusplus >= 201703L
+	//! operator+= appends a std::string_view
+	fixed_string & operator+=(std::string_view rhs) {
+		append(rhs.data(), rhs.size());
+		return *this;
+	}
+#endif
+
 	//! operator= assigns the input rhs to the fixed_string.
 	//! it uses the operator+=, which also implies that
 	//! all characters <i>after<\i> the allocated length are
 	//! discarded (and the error_char is set to '?').
 	template<typename T>
-	fixed_string & operator=(T const & rhs) {
+	typename if_not_fixed_string<T, fixed_string &>::type operator=(T const & rhs) {
 		reset();
 		return *this += rhs;
 	}
@@ -287,11 +1015,40 @@ public:
 	//! automatically creates this implementation, but it
 	//! cannot know what to do with the const attributs
 	//! of the fixed_string.
+	//! It is also the one routine that assigns fixed_strings
+	//! of any length to each other.
 	fixed_string & operator=(const fixed_string & rhs) {
+		if (this != &rhs) {
+			reset();
+			append(rhs.c_str(), rhs.get_used_length());
+		}
+		return *this;
+	}
+
+	//! operator= assigns a char array, see operator+=
+	template<typename C, int K>
+	typename if_char<C, fixed_string &>::type operator=(C (&rhs)[K]) {
 		reset();
-		return *this += rhs;
+		append(rhs, array_length(rhs));
+		return *this;
+	}
+
+	//! operator= assigns a std::string, using its size()
+	fixed_string & operator=(const std::string & rhs) {
+		reset();
+		append(rhs.data(), rhs.size());
+		return *this;
 	}
 
+#if __cplusplus >= 201703L
+	//! operator= assigns a std::string_view
+	fixed_string & operator=(std::string_view rhs) {
+		reset();
+		append(rhs.data(), rhs.size());
+		return *this;
+	}
+#endif
+
 	//! operator== compares the rhs (char, char *,
 	//! fixed_string) whith its own buffer. To
 	//! prevent massive code duplication comparing
@@ -305,8 +1062,8 @@ public:
 	//!
 	//! All other combinations return false
 	template<typename T>
-	bool operator==(T const & rhs) const {
-		return compare(rhs) == 0;
+	bool operator==(T && rhs) const {
+		return compare(std::forward<T>(rhs)) == 0;
 	}
 
 	//! operator!= compares the rhs (char, char *,
@@ -321,8 +1078,8 @@ public:
 	//!
 	//! All other combinations return false
 	template<typename T>
-	bool operator!=(T const & rhs) const {
-		return compare(rhs) != 0;
+	bool operator!=(T && rhs) const {
+		return compare(std::forward<T>(rhs)) != 0;
 	}
 
 	//! operator> compares the rhs (char, char *,
@@ -338,8 +1095,8 @@ public:
 	//!
 	//! All other combinations return false
 	template<typename T>
-	bool operator>(T const & rhs) const {
-		return compare(rhs) > 0;
+	bool operator>(T && rhs) const {
+		return compare(std::forward<T>(rhs)) > 0;
 	}
 
 	//! operator< compares the rhs (char, char *,
@@ -355,8 +1112,8 @@ public:
 	//!
 	//! All other combinations return false
 	template<typename T>
-	bool operator<(T const & rhs) const {
-		return compare(rhs) < 0;
+	bool operator<(T && rhs) const {
+		return compare(std::forward<T>(rhs)) < 0;
 	}
 	//! operator<= compares the rhs (char, char *,
 	//! fixed_string) whith its own buffer. To
@@ -373,8 +1130,8 @@ public:
 	//!
 	//! All other combinations return false
 	template<typename T>
-	bool operator<=(T const & rhs) const {
-		return compare(rhs) <= 0;
+	bool operator<=(T && rhs) const {
+		return compare(std::forward<T>(rhs)) <= 0;
 	}
 
 	//! operator>= compares the rhs (char, char *,
@@ -392,22 +1149,19 @@ public:
 	//!
 	//! All other combinations return false
 	template<typename T>
-	bool operator>=(T const & rhs) const {
-		return compare(rhs) >= 0;
+	bool operator>=(T && rhs) const {
+		return compare(std::forward<T>(rhs)) >= 0;
 	}
 
 	//! return n'th character, if valid
 	//! else return error character
 	char & operator[](int n) {
-		if (valid(n))
-			return pBuff[n];
-		else {
-#if defined(CANTHROWSTDEXCEPTIONS)
-			throw std::out_of_range("out_of_range");
+#if defined(DEFERREDTERMINATOR)
+		// the terminator may not have been written yet
+		if (n == used_length)
+			pBuff[n] = '\0';
 #endif
-			return error_char;
-		}
-
+		return element(n);
 	}
 
 	//! return n'th character, if valid
@@ -415,6 +1169,11 @@ public:
 	//! const, because character cannot
 	//! be changed with this method
 	char operator[](int n) const {
+#if defined(DEFERREDTERMINATOR)
+		// the terminator may not have been written yet
+		if (n == used_length)
+			return '\0';
+#endif
 		return valid(n) ? pBuff[n] : '?';
 	}
 
@@ -456,6 +1215,19 @@ public:
 #endif
 	}
 
+#if __cplusplus >= 201703L
+	//! The string as a std::string_view, without a copy or
+	//! a strlen(), and without needing the null-terminator
+	std::string_view as_view() const {
+		return std::string_view(pBuff, get_used_length());
+	}
+
+	//! Passes the string to functions taking a std::string_view
+	operator std::string_view() const {
+		return as_view();
+	}
+#endif
+
 protected:
 	//! Method to externally define a new
 	//! used_length value. Used for swap()
@@ -465,6 +1237,24 @@ protected:
 			used_length = newvalue;
 	}
 
+	//! The length of a char array, a string literal or a buffer:
+	//! up to its first '\0', at most K - 1. A const array may hold
+	//! a shorter string with bytes left behind its terminator, so
+	//! it is measured as well; for a literal the compiler folds
+	//! the memchr() into a constant.
+	template<int K>
+	static int array_length(const char (&s)[K]) {
+		const void * end = std::memchr(s, '\0', K - 1);
+		return end ? static_cast<const char *>(end) - s : K - 1;
+	}
+
+	//! Sets an empty string to [s, s + len), which the caller
+	//! knows fits, without the checks of append()
+	void assign_fitting(const char * s, int len) {
+		std::memcpy(pBuff, s, len);
+		set_length(len);
+	}
+
 public:
 	//! the swap method allows two fixed_strings
 	//! to have their values swapped. All chars
@@ -474,6 +1264,9 @@ public:
 	//! longest string (used_length) and swaps
 	//! each character 1 by 1
 	fixed_string & swap(fixed_string& rhs) {
+		// the loop below relies on both null-terminators
+		c_str();
+		rhs.c_str();
 		if (get_used_length() >= rhs.get_used_length()) {
 			// 'reset' this string
 			used_length = 0;
@@ -483,20 +1276,20 @@ public:
 					if (valid(used_length)) {
 						// We cannot use append(char) as we are reading
 						// from current buffer
-						pBuff[used_length] = rhs[used_length];
+						pBuff[used_length] = rhs.element(used_length);
 					}
 
-					if (rhs[used_length] != '\0') {
+					if (rhs.element(used_length) != '\0') {
 						used_length++;
 					} else {
 						// lhs finished, append lhs tail to rhs
 						rhs.set_used_length(used_length + 1);
-						rhs[used_length] = ch;
+						rhs.element(used_length) = ch;
 						rhs += &pBuff[used_length + 1];
 						break;
 					}
 					rhs.set_used_length(used_length);
-					rhs[used_length - 1] = ch;
+					rhs.element(used_length - 1) = ch;
 
 				} else if (used_length == rhs.get_allocated_length() - 1) {
 					rhs.set_used_length(used_length);
@@ -516,6 +1309,20 @@ private:
 		return (pos >= 0 && pos < (allocated_length - 1));
 	}
 
+	//! n'th character of the buffer, whatever the length, else
+	//! the error character; swap() reads the bytes behind the
+	//! length of rhs, which operator[] may overwrite
+	char & element(int n) {
+		if (valid(n))
+			return pBuff[n];
+		else {
+#if defined(CANTHROWSTDEXCEPTIONS)
+			throw std::out_of_range("out_of_range");
+#endif
+			return error_char;
+		}
+	}
+
 	void reset() {
 #if defined(OPTIMIZEFORSPEED)
 		used_length = 0;
@@ -523,34 +1330,213 @@ private:
 		pBuff[0] = '\0';
 	}
 
+	//! The growing replace() of [o, o + keep) of the buffer itself,
+	//! a source that reaches into the tail: moving the tail first
+	//! would overwrite it, and copying it first would overwrite the
+	//! tail. Every character is read before it is overwritten.
+	void grow_from_self(int pos, int count, int o, int keep, int tail_keep) {
+		const int grow = keep - count;
+		const int first = pos + count;
+		const int end = o + keep;
+		const int tail_end = first + tail_keep;
+		// the kept tail behind the source moves up
+		if (tail_end > end)
+			std::memmove(pBuff + end + grow, pBuff + end, tail_end - end);
+		// the source moves to pos: a part in front of pos is copied,
+		// a start behind pos rotated to the front
+		if (o < pos) {
+			std::memmove(pBuff + 2 * pos - o, pBuff + pos, end - pos);
+			std::memcpy(pBuff + pos, pBuff + o, pos - o);
+		} else
+			std::rotate(pBuff + pos, pBuff + o, pBuff + end);
+		// the kept tail inside [pos, end): in front of o it was rotated
+		// up by keep, from o on it is part of the source at pos
+		const int stop = std::min(end, tail_end);
+		if (std::min(o, stop) > first)
+			std::memmove(pBuff + first + grow, pBuff + first + keep, std::min(o, stop) - first);
+		const int from = std::max(o, first);
+		if (stop > from)
+			std::memcpy(pBuff + from + grow, pBuff + pos + from - o, stop - from);
+	}
+
+	//! Appends [s, s + len) as far as it fits, like append();
+	//! returns false if not all of it did
+	bool append_part(const char * s, int len) {
+		const bool fits = len <= allocated_length - 1 - get_used_length();
+		append(s, len);
+		return fits;
+	}
+
+	//! Appends [s, s + len) only if all of it fits, else
+	//! handles the overflow; returns false if it did not fit
+	bool append_whole(const char * s, int len) {
+		const int used = get_used_length();
+		if (len > allocated_length - 1 - used) {
+			cut(used, used + len);
+			return false;
+		}
+		std::memcpy(pBuff + used, s, len);
+		set_length(used + len);
+		return true;
+	}
+
+	//! Returns how many of len characters fit in the buffer,
+	//! for the ..._into() members that write it directly
+	int fit(int len) const {
+		return len < allocated_length - 1 ? len : allocated_length - 1;
+	}
+
+	//! Ends a direct write of n characters into the buffer, which
+	//! wanted to be wanted characters long
+	void finish(int n, int wanted) {
+		if (n < wanted)
+			cut(n, wanted);
+		else
+			set_length(n);
+	}
+
+	//! Makes the string n characters longer and returns where the
+	//! new characters go, or 0 (after overflow()) if they do not fit
+	char * make_room(int n) {
+		const int used = get_used_length();
+		if (n > allocated_length - 1 - used) {
+			overflow(n);
+			return 0;
+		}
+		set_length(used + n);
+		return pBuff + used;
+	}
+
+	//! clamps n to the range [0, max]
+	static int clamp(int n, int max) {
+		return n < 0 ? 0 : (n > max ? max : n);
+	}
+
+	//! Returns the position of the first occurrence of
+	//! [s, s + len) at or after pos, or -1 if there is none.
+	//! memchr finds the candidates for the first character.
+	int find(const char * s, int len, int pos) const {
+		const int used = get_used_length();
+		if (pos > used - len)
+			return -1;
+		const char * last = pBuff + used - len;
+		for (const char * p = pBuff + pos; p <= last; p++) {
+			p = static_cast<const char *>(std::memchr(p, s[0], last - p + 1));
+			if (p == 0)
+				return -1;
+			if (std::memcmp(p, s, len) == 0)
+				return p - pBuff;
+		}
+		return -1;
+	}
+
+	//! sets the length of the string to n and
+	//! writes the null-terminator behind it
+	void set_length(int n) {
+#if defined(OPTIMIZEFORSPEED)
+		used_length = n;
+#endif
+		pBuff[n] = '\0';
+#if defined(FIXEDSTRINGSTATISTICS)
+		statistics::record_length(allocated_length, n);
+#endif
+	}
+
+	//! Called when the string ran out of room: the string
+	//! wanted to be wanted characters long, but is cut at n
+	//! (at the last complete code point before n, if
+	//! UTF8SAFETRUNCATION is defined).
+	void cut(int n, int wanted) {
+#if defined(UTF8SAFETRUNCATION)
+		// never leave half a code point behind
+		n = utf8::complete_length(pBuff, n);
+#endif
+		set_length(n);
+		overflow(wanted - n);
+	}
+
+	//! called whenever characters are discarded
+	//! because the string ran out of room
+	void overflow(int dropped) {
+#if defined(FIXEDSTRINGSTATISTICS)
+		statistics::record_truncation(allocated_length, dropped);
+#endif
+		// error char deprecated
+		error_char = '?';
+#if defined(CANTHROWSTDEXCEPTIONS)
+		throw std::out_of_range("out of range");
+#endif
+	}
+
 	//! Need to implement the int compare
 	//! or the compiler implements this
 	//! method in the template
 	int compare(const int & rhs) const {
-		return compare(pBuff) <= 0;
+		return compare(c_str()) <= 0;
+	}
+
+	//! compare method for fixed_strings of any length;
+	//! not a template, see operator+=(const fixed_string &)
+	int compare(const fixed_string & rhs) const {
+		return compare(rhs.c_str(), rhs.get_used_length());
+	}
+
+	//! compare method for char arrays, see array_length()
+	template<typename C, int K>
+	typename if_char<C, int>::type compare(C (&rhs)[K]) const {
+		return compare(rhs, array_length(rhs));
+	}
+
+	//! compare methods for std::string and std::string_view,
+	//! by their size(), so embedded '\0's count too
+	int compare(const std::string & rhs) const {
+		return compare(rhs.data(), rhs.size());
+	}
+
+#if __cplusplus >= 201703L
+	int compare(std::string_view rhs) const {
+		return compare(rhs.data(), rhs.size());
+	}
+#endif
+
+	//! compares the string with [s, s + len): the first
+	//! different character decides, else the shorter
+	//! string is the smaller one
+	int compare(const char * s, int len) const {
+		const int used = get_used_length();
+		const int r = std::memcmp(pBuff, s, used < len ? used : len);
+		if (r != 0)
+			return r < 0 ? -1 : 1;
+		return used < len ? -1 : (used > len ? 1 : 0);
 	}
 
 	//! compare method for different types
-	//! types could be char, char*, fixed_string
+	//! types could be char, char*
 	//! returns when character differs
 	//! irregardless of case
 	template<typename T>
-	int compare(T const & rhs) const {
+	typename if_not_fixed_string<T, int>::type compare(T const & rhs) const {
 		int c = 0;
 		if (pBuff == 0 || rhs == 0)
 			return 0;
-		for (char ch : iter(rhs)) {
-			if (pBuff[c] > ch) // char in lhs > char of rhs
+		// the length, not the null-terminator, ends the
+		// string (see DEFERREDTERMINATOR); characters compare
+		// as unsigned, like memcmp in compare(const char *, int)
+		const int used = get_used_length();
+		for (char rc : iter(rhs)) {
+			const unsigned char ch = rc;
+			const unsigned char lhs = c < used ? pBuff[c] : '\0';
+			if (lhs > ch) // char in lhs > char of rhs
 				return 1;
-			if (pBuff[c] < ch) // char in rhs > char of lhs
+			if (lhs < ch) // char in rhs > char of lhs
 				return -1;
 			// @TODO: check this one
-			if (pBuff[c] != '\0' && ch == '\0') // rhs shorter
+			if (lhs != '\0' && ch == '\0') // rhs shorter
 				return 1;
 			c++;
 		}
-		if (rhs != '\0' && pBuff[c] != '\0') // lhs shorter
-			return -1;
+		if (c < used) // rhs shorter
+			return 1;
 		return 0; // equal in length and all chars same
 	}
 
@@ -601,25 +1587,20 @@ public:
 	//! <N> != <M>
 	fixed_string(const fixed_string<N> & rhs) :
 			fixed_string<0>(contents, length) {
-		for (char c : iter(rhs))
-			fixed_string<0>::append(c);
+		fixed_string<0>::append(rhs.c_str(), rhs.get_used_length());
 	}
 
-	//! Copy constructor. It calls the
-	//! implementation <0> to construct the object,
-	//! using the attributes contents (a char array)
+	//! Copy constructor for a fixed_string of any length.
+	//! It calls the implementation <0> to construct the
+	//! object, using the attributes contents (a char array)
 	//! and the length, which is indicated with N
 	//! (fixed_string<N>).
-	//! This function is unique for every length
-	//! of the "other" fixed_string. The compiler
-	//! will  construct these extra functions, so
-	//! use with care, or machine code can be very
-	//! lengthy.
-	template<int M>
-	fixed_string(const fixed_string<M> & rhs) :
+	//! Taking fixed_string<0> rather than fixed_string<M>
+	//! means no extra function is generated for every
+	//! length of the "other" fixed_string.
+	fixed_string(const fixed_string<0> & rhs) :
 			fixed_string<0>(contents, length) {
-		for (char c : iter(rhs)) //iters
-			fixed_string<0>::append(c);
+		fixed_string<0>::append(rhs.c_str(), rhs.get_used_length());
 	}
 
 	//! Constructor with char pointer. It calls the
@@ -627,36 +1608,64 @@ public:
 	//! using the attributes contents (a char array)
 	//! and the length, which is indicated with N
 	//! (fixed_string<N>).
-	fixed_string(const char * ch) :
+	//! A template only so that a char array prefers the
+	//! (more specialized) constructor below
+	template<typename P>
+	fixed_string(P ch, typename if_char_pointer<P, int>::type = 0) :
 			fixed_string<0>(contents, length) {
-		for (char c : iter(ch))
-			fixed_string<0>::append(c);
+		fixed_string<0>::append(ch, std::strlen(ch));
 	}
 
+	//! Constructor with std::string; takes its size()
+	//! rather than a strlen() of its c_str()
 	fixed_string(const std::string & ch) :
 			fixed_string<0>(contents, length) {
-		for (char c : iter(ch.c_str()))
-			fixed_string<0>::append(c);
+		fixed_string<0>::append(ch.data(), ch.size());
 	}
 
+	//! Constructor with a char array, e.g. a string literal,
+	//! measured by array_length(). Whether the array always fits is
+	//! known at compile time, so a literal no longer than N
+	//! is copied without the checks of append().
+	template<typename C, int K>
+	fixed_string(C (&ch)[K], typename if_char<C, int>::type = 0) :
+			fixed_string<0>(contents, length) {
+		if (K - 1 <= N)
+			fixed_string<0>::assign_fitting(ch, array_length(ch));
+		else
+			fixed_string<0>::append(ch, array_length(ch));
+	}
+
+#if __cplusplus >= 201703L
+	//! Constructor with std::string_view
+	fixed_string(std::string_view ch) :
+			fixed_string<0>(contents, length) {
+		fixed_string<0>::append(ch.data(), ch.size());
+	}
+#endif
+
 	/*	operator fixed_string() const {
 	 return (fixed_string<0> ) *this;
 	 }
 	 */
 
-	//! Assignment operator. This function yields in
-	//! unique functions for every fixed_string<M>, so
-	//! be carefull using this function, as it will
-	//! enlarge your machinecode for every use of the
-	//! assignment.
-	template<int M>
-	fixed_string<0> & operator=(const fixed_string<M> & rhs) {
-		return fixed_string<0>::operator=(rhs);
+	//! Assignment operators of the implementation <0>,
+	//! for char, char * and fixed_strings of any length
+	using fixed_string<0>::operator=;
+
+	//! Copy assignment. Explicitly defined, else the
+	//! compiler copies the whole contents array after
+	//! fixed_string<0>::operator= has copied the string.
+	fixed_string & operator=(const fixed_string & rhs) {
+		fixed_string<0>::operator=(rhs);
+		return *this;
 	}
 
 private:
-	//! Buffer for the chars stored in the object
-	char contents[N + 1];
+	//! Buffer for the chars stored in the object;
+	//! mutable as c_str() may write the null-terminator
+	//! of a const object (DEFERREDTERMINATOR)
+	mutable char contents[N + 1];
 	//! The  length of the fixed_object.
 	static const int length = N + 1;
 };
@@ -682,8 +1691,7 @@ public:
 	fixed_string_with_guard(char * c) :
 			fixed_string<0>(contents + 2, length) {
 		init();
-		for (char c : iter(c))
-			fixed_string<0>::append(c);
+		fixed_string<0>::append(c, std::strlen(c));
 	}
 
 	bool check_padding() {
@@ -704,10 +1712,25 @@ public:
 	}
 
 private:
-	//! Buffer for the chars stored in the object
-	char contents[20];
+	//! Buffer for the chars stored in the object;
+	//! mutable as c_str() may write the null-terminator
+	//! of a const object (DEFERREDTERMINATOR)
+	mutable char contents[20];
 	//! The  length of the fixed_object.
 	static const int length = 16;
 };
 } // namespace fixed_string
+
+namespace std {
+
+//! std::hash for fixed_strings, so they can be keys of unordered
+//! containers; see fixed_string<0>::hash()
+template<int N>
+struct hash< ::fixed_string::fixed_string<N> > {
+	size_t operator()(const ::fixed_string::fixed_string<N> & fs) const {
+		return fs.hash();
+	}
+};
+
+} // namespace std
 #endif
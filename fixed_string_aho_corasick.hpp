@@ -0,0 +1,228 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_aho_corasick.hpp
+ *
+ *  Searches a fixed_string for many patterns at once, in one pass,
+ *  using an Aho-Corasick automaton with a dense, statically sized
+ *  transition table.
+ */
+
+#ifndef FIXED_STRING_AHO_CORASICK_HPP_
+#define FIXED_STRING_AHO_CORASICK_HPP_
+
+#include <cstring>
+#include <stdint.h>
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+
+//! @brief multi-pattern search with a heap-free Aho-Corasick automaton
+//! @details
+//! MaxStates bounds the number of states, which is at most one more
+//! than the total length of all patterns; MaxPatterns bounds the number
+//! of patterns. The transition table takes MaxStates * 512 bytes, so
+//! large automata are best declared static.
+//! Usage:
+//! \code
+//! static aho_corasick<4096, 256> banned;
+//! banned.add("foo");
+//! banned.add("bar");
+//! banned.build();
+//! if (banned.find_any(message) >= 0) { }
+//! \endcode
+//! After build() every state has a transition for every byte, so the
+//! search is a single table lookup per character of the text.
+template<int MaxStates, int MaxPatterns>
+class aho_corasick {
+public:
+	static_assert(MaxStates > 0 && MaxStates <= 65536, "states must fit in 16 bits");
+	static_assert(MaxPatterns > 0 && MaxPatterns <= 32767, "pattern index must fit in 16 bits");
+
+	aho_corasick() :
+			states(1), patterns(0), built(false) {
+		std::memset(next[0], 0, sizeof(next[0]));
+		output[0] = -1;
+		dict[0] = 0;
+	}
+
+	//! Adds the pattern [s, s + len) and returns its index, or -1 if the
+	//! pattern is empty, the automaton is full or build() was already
+	//! called. Adding a pattern twice returns the index of the first.
+	int add(const char * s, int len) {
+		if (built || len <= 0 || patterns == MaxPatterns)
+			return -1;
+		int st = 0;
+		for (int i = 0; i < len; i++) {
+			const unsigned char c = s[i];
+			if (next[st][c] == 0) {
+				if (states == MaxStates)
+					return -1;
+				std::memset(next[states], 0, sizeof(next[states]));
+				output[states] = -1;
+				next[st][c] = states++;
+			}
+			st = next[st][c];
+		}
+		if (output[st] < 0) {
+			output[st] = patterns;
+			lengths[patterns] = len;
+			patterns++;
+		}
+		return output[st];
+	}
+
+	//! Adds a null-terminated pattern, see add(const char *, int)
+	int add(const char * s) {
+		return add(s, std::strlen(s));
+	}
+
+	//! Adds the contents of a fixed_string as pattern
+	int add(const fixed_string<0> & fs) {
+		return add(fs.c_str(), fs.get_used_length());
+	}
+
+	//! Computes the failure transitions. Call once, after all
+	//! patterns have been added and before searching; further
+	//! calls do nothing.
+	void build() {
+		if (built)
+			return;
+		int head = 0, tail = 0;
+		for (int c = 0; c < 256; c++) {
+			const int s = next[0][c];
+			if (s) {
+				fail[s] = 0;
+				dict[s] = 0;
+				queue[tail++] = s;
+			}
+		}
+		while (head < tail) {
+			const int r = queue[head++];
+			for (int c = 0; c < 256; c++) {
+				const int s = next[r][c];
+				if (s == 0) {
+					// missing transition: follow the failure link,
+					// whose row is already complete (BFS order)
+					next[r][c] = next[fail[r]][c];
+					continue;
+				}
+				const int f = next[fail[r]][c];
+				fail[s] = f;
+				dict[s] = output[f] >= 0 ? f : dict[f];
+				queue[tail++] = s;
+			}
+		}
+		built = true;
+	}
+
+	//! Returns the index of the pattern that ends first in
+	//! [s, s + len), or -1 if none of the patterns occurs or
+	//! build() has not been called
+	int find_any(const char * s, int len) const {
+		if (!built)
+			return -1;
+		int st = 0;
+		for (int i = 0; i < len; i++) {
+			st = next[st][static_cast<unsigned char>(s[i])];
+			const int t = output[st] >= 0 ? st : dict[st];
+			if (t)
+				return output[t];
+		}
+		return -1;
+	}
+
+	int find_any(const fixed_string<0> & fs) const {
+		return find_any(fs.c_str(), fs.get_used_length());
+	}
+
+	//! Calls f(pattern, position) for every occurrence of every
+	//! pattern in [s, s + len), in order of the position where the
+	//! occurrence ends. Occurrences may overlap. Nothing is
+	//! found before build().
+	template<typename F>
+	void find_all(const char * s, int len, F f) const {
+		if (!built)
+			return;
+		int st = 0;
+		for (int i = 0; i < len; i++) {
+			st = next[st][static_cast<unsigned char>(s[i])];
+			for (int t = output[st] >= 0 ? st : dict[st]; t; t = dict[t])
+				f(output[t], i + 1 - lengths[output[t]]);
+		}
+	}
+
+	template<typename F>
+	void find_all(const fixed_string<0> & fs, F f) const {
+		find_all(fs.c_str(), fs.get_used_length(), f);
+	}
+
+	//! Returns the number of occurrences of all patterns in
+	//! [s, s + len), or -1 if build() has not been called
+	int count(const char * s, int len) const {
+		if (!built)
+			return -1;
+		int n = 0;
+		int st = 0;
+		for (int i = 0; i < len; i++) {
+			st = next[st][static_cast<unsigned char>(s[i])];
+			for (int t = output[st] >= 0 ? st : dict[st]; t; t = dict[t])
+				n++;
+		}
+		return n;
+	}
+
+	int count(const fixed_string<0> & fs) const {
+		return count(fs.c_str(), fs.get_used_length());
+	}
+
+	//! Returns the number of (distinct) patterns added
+	int get_pattern_count() const {
+		return patterns;
+	}
+
+	//! Returns the number of states in use
+	int get_state_count() const {
+		return states;
+	}
+
+private:
+	//! transition table, complete after build()
+	uint16_t next[MaxStates][256];
+	//! pattern ending in a state, or -1
+	int16_t output[MaxStates];
+	//! nearest state on the failure chain that has an output, or 0
+	uint16_t dict[MaxStates];
+	//! failure links and BFS queue, only used by build()
+	uint16_t fail[MaxStates];
+	uint16_t queue[MaxStates];
+	//! length of every pattern
+	int lengths[MaxPatterns];
+
+	int states;
+	int patterns;
+	bool built;
+};
+
+} // namespace fixed_string
+#endif /* FIXED_STRING_AHO_CORASICK_HPP_ */
@@ -0,0 +1,128 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_arena.hpp
+ *
+ *  Hands out fixed_strings with a capacity chosen at runtime,
+ *  bump-allocated from a block of memory owned by the caller.
+ */
+
+#ifndef FIXED_STRING_ARENA_HPP_
+#define FIXED_STRING_ARENA_HPP_
+
+#include <new>
+#include <utility>
+#include <stdint.h>
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+
+//! @brief bump allocator for fixed_strings of runtime capacity
+//! @details
+//! Usage:
+//! \code
+//! static char block[4096];
+//! fixed_string_arena arena(block, sizeof(block));
+//! fixed_string<0> * name = arena.create(limit);
+//! if (name)
+//!		*name = "hello world";
+//! arena.reset(); // all strings are gone, in O(1)
+//! \endcode
+//! Each string (object and buffer) is placed directly behind the
+//! previous one. Nothing is ever freed on its own: reset() releases
+//! every string at once, so the block can never fragment.
+//! The arena does not own the block; it must outlive the arena.
+class fixed_string_arena {
+public:
+	fixed_string_arena(char * block, int size) :
+			block(block), size(size), used(0) {
+	}
+
+	//! Creates an empty fixed_string which can hold capacity characters
+	//! (like fixed_string<capacity>). Returns 0 if the block has no room
+	//! left, or throws std::bad_alloc if CANTHROWSTDEXCEPTIONS is defined.
+	//! The string is valid until the next reset().
+	fixed_string<0> * create(int capacity) {
+		const int offset = used + padding(block + used);
+		// compared before adding, so a huge capacity cannot overflow
+		if (capacity < 0 || offset > size
+				|| capacity > size - offset - (int) sizeof(arena_string) - 1) {
+#if defined(CANTHROWSTDEXCEPTIONS)
+			throw std::bad_alloc();
+#endif
+			return 0;
+		}
+		char * p = block + offset;
+		used = offset + (int) sizeof(arena_string) + capacity + 1;
+		return new (p) arena_string(p + sizeof(arena_string), capacity + 1);
+	}
+
+	//! Creates a fixed_string of the given capacity and assigns rhs
+	//! (char, char *, fixed_string) to it
+	template<typename T>
+	fixed_string<0> * create(int capacity, T && rhs) {
+		fixed_string<0> * fs = create(capacity);
+		if (fs)
+			*fs = std::forward<T>(rhs);
+		return fs;
+	}
+
+	//! Releases all strings handed out by this arena
+	void reset() {
+		used = 0;
+	}
+
+	//! Returns the number of bytes of the block in use
+	int get_used_bytes() const {
+		return used;
+	}
+
+	//! Returns the size of the block
+	int get_allocated_bytes() const {
+		return size;
+	}
+
+private:
+	//! fixed_string<0> can only be constructed by a subclass;
+	//! this one wraps a buffer in the block. It has no destructor,
+	//! which is what allows reset() to simply forget all strings.
+	class arena_string: public fixed_string<0> {
+	public:
+		arena_string(char * content, int l) :
+				fixed_string<0>(content, l) {
+		}
+	};
+
+	//! number of bytes to skip so an object at p is properly aligned
+	static int padding(const char * p) {
+		const uintptr_t a = alignof(arena_string);
+		return (a - (reinterpret_cast<uintptr_t>(p) & (a - 1))) & (a - 1);
+	}
+
+	char * const block;
+	const int size;
+	int used;
+};
+
+} // namespace fixed_string
+#endif /* FIXED_STRING_ARENA_HPP_ */
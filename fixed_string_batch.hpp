@@ -0,0 +1,272 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_batch.hpp
+ *
+ *  Applies one operation to a whole array of fixed_strings, optionally
+ *  split over the threads of a batch_pool. The array is cut into
+ *  contiguous chunks, so results always come out in array order,
+ *  however many threads are used.
+ */
+
+#ifndef FIXED_STRING_BATCH_HPP_
+#define FIXED_STRING_BATCH_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+
+//! @brief small fixed-size pool of worker threads for the batch operations
+//! @details
+//! The threads are started by the constructor and stopped by the
+//! destructor; run() hands them work without allocating. The calling
+//! thread takes part in the work, so a pool of n threads starts n - 1.
+class batch_pool {
+public:
+	static const int max_threads = 64;
+
+	explicit batch_pool(int threads) :
+			worker_count(0), task_count(0), generation(0), busy(0), stop(false), fn(0), ctx(0) {
+		next_task.store(0);
+		if (threads > max_threads)
+			threads = max_threads;
+		for (int i = 0; i < threads - 1; i++)
+			workers[worker_count++] = std::thread(&batch_pool::work, this);
+	}
+
+	~batch_pool() {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stop = true;
+		}
+		wake.notify_all();
+		for (int i = 0; i < worker_count; i++)
+			workers[i].join();
+	}
+
+	//! number of threads working on a batch, including the caller
+	int get_thread_count() const {
+		return worker_count + 1;
+	}
+
+	//! Calls f(task) for every task in [0, tasks), spread over all
+	//! threads, and returns when all tasks are done. Not reentrant.
+	template<typename F>
+	void run(int tasks, F & f) {
+		run(tasks, &call<F>, &f);
+	}
+
+private:
+	template<typename F>
+	static void call(void * f, int task) {
+		(*static_cast<F *>(f))(task);
+	}
+
+	void run(int tasks, void (*function)(void *, int), void * context) {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			fn = function;
+			ctx = context;
+			task_count = tasks;
+			next_task.store(0);
+			busy = worker_count;
+			generation++;
+		}
+		wake.notify_all();
+		take_tasks(function, context, tasks);
+		std::unique_lock<std::mutex> guard(lock);
+		while (busy > 0)
+			done.wait(guard);
+	}
+
+	void take_tasks(void (*function)(void *, int), void * context, int tasks) {
+		for (int t = next_task.fetch_add(1); t < tasks; t = next_task.fetch_add(1))
+			function(context, t);
+	}
+
+	void work() {
+		int seen = 0;
+		std::unique_lock<std::mutex> guard(lock);
+		for (;;) {
+			while (!stop && generation == seen)
+				wake.wait(guard);
+			if (stop)
+				return;
+			seen = generation;
+			void (*function)(void *, int) = fn;
+			void * context = ctx;
+			const int tasks = task_count;
+			guard.unlock();
+			take_tasks(function, context, tasks);
+			guard.lock();
+			if (--busy == 0)
+				done.notify_one();
+		}
+	}
+
+	std::thread workers[max_threads];
+	int worker_count;
+
+	std::mutex lock;
+	std::condition_variable wake, done;
+	std::atomic<int> next_task;
+	int task_count;
+	int generation;
+	int busy;
+	bool stop;
+	void (*fn)(void *, int);
+	void * ctx;
+};
+
+namespace batch {
+
+//! a chunk is never smaller than this many strings,
+//! below that the threads only cost time
+static const int min_chunk = 1024;
+//! upper bound on the number of chunks of one batch
+static const int max_chunks = 256;
+
+//! number of chunks for count strings on pool (which may be 0)
+inline int chunks(const batch_pool * pool, int count) {
+	if (pool == 0 || pool->get_thread_count() == 1)
+		return 1;
+	int n = pool->get_thread_count() * 4;
+	if (n > count / min_chunk)
+		n = count / min_chunk;
+	if (n > max_chunks)
+		n = max_chunks;
+	return n < 1 ? 1 : n;
+}
+
+//! Calls body(begin, end, chunk) for every chunk of [0, count)
+template<typename B>
+void for_chunks(batch_pool * pool, int count, B body) {
+	const int n = chunks(pool, count);
+	if (n == 1) {
+		body(0, count, 0);
+		return;
+	}
+	auto task = [&](int chunk) {
+		body(static_cast<long long>(count) * chunk / n,
+				static_cast<long long>(count) * (chunk + 1) / n, chunk);
+	};
+	pool->run(n, task);
+}
+
+} // namespace batch
+
+//! Calls f(s) for every string in [strings, strings + count);
+//! f may modify the string. With a pool, the calls are spread
+//! over its threads, so f must not depend on the order.
+template<typename T, typename F>
+void transform_all(batch_pool * pool, T * strings, int count, F f) {
+	batch::for_chunks(pool, count, [&](int begin, int end, int) {
+		for (int i = begin; i < end; i++)
+			f(strings[i]);
+	});
+}
+
+template<typename T, typename F>
+void transform_all(T * strings, int count, F f) {
+	transform_all(0, strings, count, f);
+}
+
+//! Stores the hash() of every string in out[i]
+template<typename T>
+void hash_all(batch_pool * pool, const T * strings, int count, uint64_t * out) {
+	batch::for_chunks(pool, count, [&](int begin, int end, int) {
+		for (int i = begin; i < end; i++)
+			out[i] = strings[i].hash();
+	});
+}
+
+template<typename T>
+void hash_all(const T * strings, int count, uint64_t * out) {
+	hash_all(0, strings, count, out);
+}
+
+//! Returns the number of strings for which pred(s) is true
+template<typename T, typename P>
+int count_if(batch_pool * pool, const T * strings, int count, P pred) {
+	int counts[batch::max_chunks];
+	const int n = batch::chunks(pool, count);
+	batch::for_chunks(pool, count, [&](int begin, int end, int chunk) {
+		int c = 0;
+		for (int i = begin; i < end; i++)
+			if (pred(strings[i]))
+				c++;
+		counts[chunk] = c;
+	});
+	int total = 0;
+	for (int i = 0; i < n; i++)
+		total += counts[i];
+	return total;
+}
+
+template<typename T, typename P>
+int count_if(const T * strings, int count, P pred) {
+	return count_if(0, strings, count, pred);
+}
+
+//! Writes the indices of all strings equal to key to out, in
+//! ascending order, and returns how many there are. out must have
+//! room for count indices.
+template<typename T>
+int find_equal_all(batch_pool * pool, const T * strings, int count,
+		const fixed_string<0> & key, int * out) {
+	int found[batch::max_chunks];
+	int starts[batch::max_chunks];
+	const int n = batch::chunks(pool, count);
+	const char * k = key.c_str();
+	const int len = key.get_used_length();
+	// every chunk writes its matches at its own begin...
+	batch::for_chunks(pool, count, [&](int begin, int end, int chunk) {
+		int c = 0;
+		for (int i = begin; i < end; i++)
+			if (strings[i].get_used_length() == len
+					&& std::memcmp(strings[i].c_str(), k, len) == 0)
+				out[begin + c++] = i;
+		found[chunk] = c;
+		starts[chunk] = begin;
+	});
+	// ...and the chunks are moved together afterwards
+	int total = 0;
+	for (int i = 0; i < n; i++) {
+		std::memmove(out + total, out + starts[i], found[i] * sizeof(int));
+		total += found[i];
+	}
+	return total;
+}
+
+template<typename T>
+int find_equal_all(const T * strings, int count, const fixed_string<0> & key, int * out) {
+	return find_equal_all(0, strings, count, key, out);
+}
+
+} // namespace fixed_string
+#endif /* FIXED_STRING_BATCH_HPP_ */
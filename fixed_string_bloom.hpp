@@ -0,0 +1,294 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_bloom.hpp
+ *
+ *  Statically sized Bloom filters over fixed_string keys, to reject
+ *  keys that were never inserted before a more expensive lookup. A
+ *  "no" is always right; a "maybe" is wrong with a small probability
+ *  set by the number of bits per key:
+ *
+ *      bits per key    false positives (bloom_filter)
+ *            6              5.6 %
+ *            8              2.2 %
+ *           10              0.8 %
+ *           12              0.3 %
+ *           16              0.05 %
+ *
+ *  Both filters use fixed_string<0>::hash(), the word-at-a-time hash.
+ */
+
+#ifndef FIXED_STRING_BLOOM_HPP_
+#define FIXED_STRING_BLOOM_HPP_
+
+#include <cstring>
+#include <stdint.h>
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+namespace bloom {
+
+//! number of hash functions that minimizes the false positive
+//! rate for the given bits per key: BitsPerKey * ln 2, rounded
+constexpr int hashes_for(int bits_per_key) {
+	return (bits_per_key * 693 + 500) / 1000 < 1 ? 1 : (bits_per_key * 693 + 500) / 1000;
+}
+
+//! spreads the bits of h once more, for the next hash functions
+inline uint64_t remix(uint64_t h) {
+	h ^= h >> 31;
+	h *= 0xBF58476D1CE4E5B9ULL;
+	h ^= h >> 29;
+	return h;
+}
+
+//! maps 32 random bits onto [0, n) without a division
+inline uint32_t reduce(uint32_t x, uint32_t n) {
+	return uint32_t((uint64_t(x) * n) >> 32);
+}
+
+} // namespace bloom
+
+//! @brief Bloom filter for up to MaxKeys fixed_string keys
+//! @details
+//! Usage:
+//! \code
+//! static bloom_filter<100000, 10> seen;  // about 1 % false positives
+//! seen.insert(name);
+//! if (seen.maybe_contains(name) && symbols.count(name)) { }
+//! \endcode
+//! The filter takes MaxKeys * BitsPerKey bits. More keys can be
+//! inserted, at a higher false positive rate. The bit positions come
+//! from one hash by double hashing (h1 + i * h2).
+template<int MaxKeys, int BitsPerKey = 10>
+class bloom_filter {
+public:
+	static_assert(MaxKeys > 0 && BitsPerKey > 0, "the filter needs bits");
+
+	static const int hashes = bloom::hashes_for(BitsPerKey);
+	static const int words = (MaxKeys * BitsPerKey + 63) / 64;
+	static const uint32_t bits = uint32_t(words) * 64;
+
+	bloom_filter() {
+		clear();
+	}
+
+	void clear() {
+		std::memset(bitmap, 0, sizeof(bitmap));
+	}
+
+	void insert(const char * s, int len) {
+		insert_hash(fixed_string<0>::hash(s, len));
+	}
+
+	void insert(const fixed_string<0> & fs) {
+		insert(fs.begin(), fs.get_used_length());
+	}
+
+	//! Returns false if [s, s + len) was certainly never inserted
+	bool maybe_contains(const char * s, int len) const {
+		return test_hash(fixed_string<0>::hash(s, len));
+	}
+
+	bool maybe_contains(const fixed_string<0> & fs) const {
+		return maybe_contains(fs.begin(), fs.get_used_length());
+	}
+
+	//! Inserts all strings of an array of fixed_strings
+	template<typename T>
+	void insert_all(const T * strings, int count) {
+		for (int i = 0; i < count; i++)
+			insert(strings[i].begin(), strings[i].get_used_length());
+	}
+
+	//! Tests all strings of an array of fixed_strings: out[i] is set
+	//! to maybe_contains(strings[i]). Returns the number of maybes.
+	//! The strings are hashed in groups first, so the memory loads
+	//! of a group overlap.
+	template<typename T>
+	int maybe_contains_all(const T * strings, int count, bool * out) const {
+		const int group = 8;
+		uint64_t h[group];
+		int n = 0;
+		for (int i = 0; i < count; i += group) {
+			const int g = count - i < group ? count - i : group;
+			for (int j = 0; j < g; j++) {
+				h[j] = fixed_string<0>::hash(strings[i + j].begin(), strings[i + j].get_used_length());
+#if defined(__GNUC__)
+				__builtin_prefetch(bitmap + bloom::reduce(uint32_t(h[j] >> 32), bits) / 64);
+#endif
+			}
+			for (int j = 0; j < g; j++)
+				n += out[i + j] = test_hash(h[j]);
+		}
+		return n;
+	}
+
+private:
+	void insert_hash(uint64_t h) {
+		uint32_t a = uint32_t(h >> 32);
+		const uint32_t b = uint32_t(h) | 1;
+		for (int i = 0; i < hashes; i++, a += b) {
+			const uint32_t bit = bloom::reduce(a, bits);
+			bitmap[bit / 64] |= uint64_t(1) << (bit % 64);
+		}
+	}
+
+	bool test_hash(uint64_t h) const {
+		uint32_t a = uint32_t(h >> 32);
+		const uint32_t b = uint32_t(h) | 1;
+		for (int i = 0; i < hashes; i++, a += b) {
+			const uint32_t bit = bloom::reduce(a, bits);
+			if (!(bitmap[bit / 64] & (uint64_t(1) << (bit % 64))))
+				return false;
+		}
+		return true;
+	}
+
+	uint64_t bitmap[words];
+};
+
+template<int MaxKeys, int BitsPerKey>
+const int bloom_filter<MaxKeys, BitsPerKey>::hashes;
+template<int MaxKeys, int BitsPerKey>
+const int bloom_filter<MaxKeys, BitsPerKey>::words;
+template<int MaxKeys, int BitsPerKey>
+const uint32_t bloom_filter<MaxKeys, BitsPerKey>::bits;
+
+//! @brief Bloom filter that sets and tests all bits of a key in one
+//! cache line
+//! @details
+//! The interface of bloom_filter. The upper half of the hash picks a
+//! 512 bit block, and the bits within it come from the lower half, so a
+//! lookup touches one cache line instead of one per hash function. The
+//! price is a somewhat higher false positive rate for the same bits per
+//! key (about 1 % instead of 0.8 % at 10 bits).
+template<int MaxKeys, int BitsPerKey = 10>
+class blocked_bloom_filter {
+public:
+	static_assert(MaxKeys > 0 && BitsPerKey > 0, "the filter needs bits");
+
+	static const int hashes = bloom::hashes_for(BitsPerKey);
+	static const int blocks = (MaxKeys * BitsPerKey + 511) / 512;
+
+	blocked_bloom_filter() {
+		clear();
+	}
+
+	void clear() {
+		std::memset(bitmap, 0, sizeof(bitmap));
+	}
+
+	void insert(const char * s, int len) {
+		insert_hash(fixed_string<0>::hash(s, len));
+	}
+
+	void insert(const fixed_string<0> & fs) {
+		insert(fs.begin(), fs.get_used_length());
+	}
+
+	//! Returns false if [s, s + len) was certainly never inserted
+	bool maybe_contains(const char * s, int len) const {
+		return test_hash(fixed_string<0>::hash(s, len));
+	}
+
+	bool maybe_contains(const fixed_string<0> & fs) const {
+		return maybe_contains(fs.begin(), fs.get_used_length());
+	}
+
+	//! Inserts all strings of an array of fixed_strings
+	template<typename T>
+	void insert_all(const T * strings, int count) {
+		for (int i = 0; i < count; i++)
+			insert(strings[i].begin(), strings[i].get_used_length());
+	}
+
+	//! Tests all strings of an array of fixed_strings, see
+	//! bloom_filter::maybe_contains_all()
+	template<typename T>
+	int maybe_contains_all(const T * strings, int count, bool * out) const {
+		const int group = 8;
+		uint64_t h[group];
+		int n = 0;
+		for (int i = 0; i < count; i += group) {
+			const int g = count - i < group ? count - i : group;
+			for (int j = 0; j < g; j++) {
+				h[j] = fixed_string<0>::hash(strings[i + j].begin(), strings[i + j].get_used_length());
+#if defined(__GNUC__)
+				__builtin_prefetch(block(h[j]));
+#endif
+			}
+			for (int j = 0; j < g; j++)
+				n += out[i + j] = test_hash(h[j]);
+		}
+		return n;
+	}
+
+private:
+	const uint64_t * block(uint64_t h) const {
+		return bitmap[bloom::reduce(uint32_t(h >> 32), blocks)];
+	}
+
+	//! calls f(word, mask) for every bit of the key; the bit
+	//! numbers are 9 bit fields of the remixed lower half, seven
+	//! per 64 bits
+	template<typename F>
+	static bool each_bit(uint64_t h, F f) {
+		uint64_t seed = bloom::remix(uint32_t(h));
+		uint64_t x = seed;
+		for (int i = 0; i < hashes; i++) {
+			if (i % 7 == 0 && i > 0)
+				x = seed = bloom::remix(seed + 0x9E3779B97F4A7C15ULL);
+			const int bit = x & 511;
+			x >>= 9;
+			if (!f(bit / 64, uint64_t(1) << (bit % 64)))
+				return false;
+		}
+		return true;
+	}
+
+	void insert_hash(uint64_t h) {
+		uint64_t * b = bitmap[bloom::reduce(uint32_t(h >> 32), blocks)];
+		each_bit(h, [b](int w, uint64_t mask) {
+			b[w] |= mask;
+			return true;
+		});
+	}
+
+	bool test_hash(uint64_t h) const {
+		const uint64_t * b = block(h);
+		return each_bit(h, [b](int w, uint64_t mask) {
+			return (b[w] & mask) != 0;
+		});
+	}
+
+	alignas(64) uint64_t bitmap[blocks][8];
+};
+
+template<int MaxKeys, int BitsPerKey>
+const int blocked_bloom_filter<MaxKeys, BitsPerKey>::hashes;
+template<int MaxKeys, int BitsPerKey>
+const int blocked_bloom_filter<MaxKeys, BitsPerKey>::blocks;
+
+} // namespace fixed_string
+#endif /* FIXED_STRING_BLOOM_HPP_ */
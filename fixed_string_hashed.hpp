@@ -0,0 +1,345 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_hashed.hpp
+ *
+ *  hashed_fixed_string<N>: a fixed_string that keeps its hash, for
+ *  strings that are looked up far more often than they change (map
+ *  keys). Appends update the hash as they go; edits in place
+ *  recompute it once they are done, so reading it never writes.
+ */
+
+#ifndef FIXED_STRING_HASHED_HPP_
+#define FIXED_STRING_HASHED_HPP_
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+
+template<int N> class hashed_fixed_string;
+
+//! true for hashed_fixed_strings of any length
+template<typename T>
+struct is_hashed: std::false_type {
+};
+
+template<int N>
+struct is_hashed<hashed_fixed_string<N> > : std::true_type {
+};
+
+//! enable_if for the forwarding members of hashed_fixed_string,
+//! which must leave hashed_fixed_strings to their own overloads
+template<typename T, typename R>
+struct if_not_hashed: std::enable_if<
+		!is_hashed<typename std::decay<T>::type>::value, R> {
+};
+
+//! @brief fixed_string<N> with a cached hash
+//! @details
+//! Usage:
+//! \code
+//! std::unordered_map<hashed_fixed_string<32>, int> counts;
+//! hashed_fixed_string<32> key("metrics.");
+//! key += host;           // the hash follows every append
+//! counts[key]++;         // hashing the key costs O(1)
+//! key.edit([](fixed_string<0> & s) { s.replace_all(".", "/"); });
+//! \endcode
+//! The hash is a polynomial over the characters, so appending one
+//! character is a multiply and an add. Only the appending members are
+//! offered directly; any other change goes through edit(), after which
+//! the hash is recomputed. A const hashed_fixed_string is never written,
+//! so threads may share one.
+//! Two hashed_fixed_strings compare their hashes and lengths before
+//! their characters, so most unequal strings are rejected in O(1).
+template<int N>
+class hashed_fixed_string {
+public:
+	hashed_fixed_string() :
+			rolled(0) {
+	}
+
+	//! Constructor with char, char * or fixed_string
+	template<typename T>
+	hashed_fixed_string(T && rhs, typename if_not_hashed<T, int>::type = 0) :
+			rolled(0) {
+		*this += std::forward<T>(rhs);
+	}
+
+	hashed_fixed_string(const hashed_fixed_string & rhs) :
+			value(rhs.value), rolled(rhs.rolled) {
+	}
+
+	hashed_fixed_string & operator=(const hashed_fixed_string & rhs) {
+		value = rhs.value;
+		rolled = rhs.rolled;
+		return *this;
+	}
+
+	//! Assigns a hashed_fixed_string of another length
+	template<int M>
+	hashed_fixed_string & operator=(const hashed_fixed_string<M> & rhs) {
+		clear();
+		return *this += rhs;
+	}
+
+	//! Assigns a char, char * or fixed_string
+	template<typename T>
+	typename if_not_hashed<T, hashed_fixed_string &>::type operator=(T && rhs) {
+		clear();
+		return *this += std::forward<T>(rhs);
+	}
+
+	//! Appends a char, char * or fixed_string; the hash is
+	//! extended by the characters that fit
+	template<typename T>
+	typename if_not_hashed<T, hashed_fixed_string &>::type operator+=(T && rhs) {
+		const int used = value.get_used_length();
+		value += std::forward<T>(rhs);
+		extend(used);
+		return *this;
+	}
+
+	//! Appends a hashed_fixed_string of any length
+	template<int M>
+	hashed_fixed_string & operator+=(const hashed_fixed_string<M> & rhs) {
+		append(rhs.begin(), rhs.get_used_length());
+		return *this;
+	}
+
+	//! Appends a single character
+	void append(char c) {
+		const int used = value.get_used_length();
+		value.append(c);
+		extend(used);
+	}
+
+	//! Appends len characters starting at s
+	void append(const char * s, int len) {
+		const int used = value.get_used_length();
+		value.append(s, len);
+		extend(used);
+	}
+
+	void clear() {
+		value = "";
+		rolled = 0;
+	}
+
+	//! Calls f with the string as fixed_string<0> &, for any change
+	//! the appending members do not cover. The hash is recomputed
+	//! when f returns.
+	template<typename F>
+	void edit(F f) {
+		f(static_cast<fixed_string<0> &>(value));
+		rolled = roll(0, value.begin(), value.get_used_length());
+	}
+
+	//! The string itself, read-only
+	const fixed_string<N> & str() const {
+		return value;
+	}
+
+	operator const fixed_string<N> &() const {
+		return value;
+	}
+
+	const char * c_str() const {
+		return value.c_str();
+	}
+
+	int get_used_length() const {
+		return value.get_used_length();
+	}
+
+	int get_allocated_length() const {
+		return value.get_allocated_length();
+	}
+
+	char operator[](int n) const {
+		return value[n];
+	}
+
+	const char * begin() const {
+		return value.begin();
+	}
+
+	const char * end() const {
+		return value.end();
+	}
+
+	//! Returns the hash in O(1). Not the same value as
+	//! fixed_string<0>::hash().
+	uint64_t hash() const {
+		uint64_t h = polynomial() ^ (value.get_used_length() * 0x9E3779B97F4A7C15ULL);
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	//! Equal hashed_fixed_strings of any length: hashes and lengths
+	//! are compared first, the characters only if those match
+	template<int M>
+	bool operator==(const hashed_fixed_string<M> & rhs) const {
+		return polynomial() == rhs.polynomial()
+				&& value.get_used_length() == rhs.get_used_length()
+				&& value == rhs.str();
+	}
+
+	template<int M>
+	bool operator!=(const hashed_fixed_string<M> & rhs) const {
+		return !(*this == rhs);
+	}
+
+	template<int M>
+	bool operator<(const hashed_fixed_string<M> & rhs) const {
+		return value < rhs.str();
+	}
+
+	template<int M>
+	bool operator<=(const hashed_fixed_string<M> & rhs) const {
+		return value <= rhs.str();
+	}
+
+	template<int M>
+	bool operator>(const hashed_fixed_string<M> & rhs) const {
+		return value > rhs.str();
+	}
+
+	template<int M>
+	bool operator>=(const hashed_fixed_string<M> & rhs) const {
+		return value >= rhs.str();
+	}
+
+	//! Comparisons with char, char * and fixed_strings are
+	//! those of fixed_string; forwarded, so char arrays keep
+	//! their length (see array_length())
+	template<typename T>
+	typename if_not_hashed<T, bool>::type operator==(T && rhs) const {
+		return value == std::forward<T>(rhs);
+	}
+
+	template<typename T>
+	typename if_not_hashed<T, bool>::type operator!=(T && rhs) const {
+		return value != std::forward<T>(rhs);
+	}
+
+	template<typename T>
+	typename if_not_hashed<T, bool>::type operator<(T && rhs) const {
+		return value < std::forward<T>(rhs);
+	}
+
+	template<typename T>
+	typename if_not_hashed<T, bool>::type operator<=(T && rhs) const {
+		return value <= std::forward<T>(rhs);
+	}
+
+	template<typename T>
+	typename if_not_hashed<T, bool>::type operator>(T && rhs) const {
+		return value > std::forward<T>(rhs);
+	}
+
+	template<typename T>
+	typename if_not_hashed<T, bool>::type operator>=(T && rhs) const {
+		return value >= std::forward<T>(rhs);
+	}
+
+	//! The polynomial over the characters, before mixing:
+	//! c[0] * B^(n-1) + ... + c[n-1]
+	uint64_t polynomial() const {
+		return rolled;
+	}
+
+	//! Extends polynomial h by [s, s + len), four characters per step
+	//! so the multiplies do not wait on each other
+	static uint64_t roll(uint64_t h, const char * s, int len) {
+		const uint64_t b1 = base;
+		const uint64_t b2 = b1 * b1;
+		const uint64_t b3 = b2 * b1;
+		const uint64_t b4 = b2 * b2;
+		const unsigned char * p = reinterpret_cast<const unsigned char *>(s);
+		int i = 0;
+		for (; i + 4 <= len; i += 4)
+			h = h * b4 + p[i] * b3 + p[i + 1] * b2 + p[i + 2] * b1 + p[i + 3];
+		for (; i < len; i++)
+			h = h * b1 + p[i];
+		return h;
+	}
+
+private:
+	//! odd multiplier of the polynomial (the 64 bit FNV prime)
+	static const uint64_t base = 0x100000001B3ULL;
+
+	//! hashes the characters appended behind used
+	void extend(int used) {
+		const int now = value.get_used_length();
+		if (now < used)
+			// a truncation backed off into the old characters
+			rolled = roll(0, value.begin(), now);
+		else
+			rolled = roll(rolled, value.begin() + used, now - used);
+	}
+
+	fixed_string<N> value;
+	uint64_t rolled;
+};
+
+//! fixed_string (char *) on the left of a hashed_fixed_string
+template<int N>
+bool operator==(const fixed_string<0> & lhs, const hashed_fixed_string<N> & rhs) {
+	return rhs == lhs;
+}
+
+template<int N>
+bool operator!=(const fixed_string<0> & lhs, const hashed_fixed_string<N> & rhs) {
+	return rhs != lhs;
+}
+
+template<int N>
+bool operator==(const char * lhs, const hashed_fixed_string<N> & rhs) {
+	return rhs == lhs;
+}
+
+template<int N>
+bool operator!=(const char * lhs, const hashed_fixed_string<N> & rhs) {
+	return rhs != lhs;
+}
+
+} // namespace fixed_string
+
+namespace std {
+
+//! std::hash for hashed_fixed_strings: returns the cached hash
+template<int N>
+struct hash< ::fixed_string::hashed_fixed_string<N> > {
+	size_t operator()(const ::fixed_string::hashed_fixed_string<N> & fs) const {
+		return fs.hash();
+	}
+};
+
+} // namespace std
+#endif /* FIXED_STRING_HASHED_HPP_ */
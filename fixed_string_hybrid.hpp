@@ -0,0 +1,592 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_hybrid.hpp
+ *
+ *  hybrid_string<N>: a fixed_string<N> that moves to a larger buffer
+ *  from an allocator once it outgrows its N characters, instead of
+ *  truncating. The default allocator is a static pool, so no heap is
+ *  involved at all.
+ */
+
+#ifndef FIXED_STRING_HYBRID_HPP_
+#define FIXED_STRING_HYBRID_HPP_
+
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#include <string_view>
+#endif
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+
+//! @brief allocator for hybrid_strings: a static pool of Bytes bytes
+//! @details
+//! Blocks are powers of two from 32 bytes up; freed blocks go on a
+//! free list per size and are handed out again before the pool is
+//! cut further, so the pool never calls the heap and, with strings
+//! of a few sizes, stops growing once it has seen the largest number
+//! of them alive at once. All pool_allocator<Bytes> share one pool,
+//! guarded by a mutex. allocate() returns 0 when the pool is used
+//! up; the string then truncates, like a fixed_string.
+template<int Bytes = (1 << 20)>
+class pool_allocator {
+public:
+	//! Returns a block of at least n bytes, or 0
+	char * allocate(int n) {
+		return instance().allocate(n);
+	}
+
+	//! Returns the block p of n bytes (as passed to allocate())
+	void deallocate(char * p, int n) {
+		instance().deallocate(p, n);
+	}
+
+	//! Bytes of the pool cut into blocks so far
+	static int get_used_bytes() {
+		pool & p = instance();
+		std::lock_guard<std::mutex> guard(p.lock);
+		return p.used;
+	}
+
+private:
+	static const int min_block = 32;
+	static const int classes = 26;
+	static_assert(Bytes > 0 && Bytes <= (min_block << (classes - 1)), "the largest block must fit a size class");
+
+	struct pool {
+		alignas(16) char block[Bytes];
+		int used;
+		//! first free block of each size; a free block holds
+		//! the pointer to the next one
+		char * free[classes];
+		std::mutex lock;
+
+		pool() :
+				used(0) {
+			for (int c = 0; c < classes; c++)
+				free[c] = 0;
+		}
+
+		//! size class of n bytes: blocks of min_block << class
+		static int size_class(int n) {
+			int c = 0;
+			while ((min_block << c) < n)
+				c++;
+			return c;
+		}
+
+		char * allocate(int n) {
+			if (n <= 0 || n > Bytes)
+				return 0;
+			const int c = size_class(n);
+			std::lock_guard<std::mutex> guard(lock);
+			char * p = free[c];
+			if (p) {
+				std::memcpy(&free[c], p, sizeof(char *));
+				return p;
+			}
+			const int size = min_block << c;
+			if (size > Bytes - used)
+				return 0;
+			p = block + used;
+			used += size;
+			return p;
+		}
+
+		void deallocate(char * p, int n) {
+			const int c = size_class(n);
+			std::lock_guard<std::mutex> guard(lock);
+			std::memcpy(p, &free[c], sizeof(char *));
+			free[c] = p;
+		}
+	};
+
+	//! the pool, created on first use
+	static pool & instance() {
+		static pool p;
+		return p;
+	}
+};
+
+//! @brief allocator for hybrid_strings: operator new
+class heap_allocator {
+public:
+	char * allocate(int n) {
+		return new (std::nothrow) char[n];
+	}
+
+	void deallocate(char * p, int) {
+		delete[] p;
+	}
+};
+
+#if __cplusplus >= 201703L
+//! @brief allocator for hybrid_strings: a std::pmr::memory_resource,
+//! e.g. a std::pmr::monotonic_buffer_resource over a local buffer
+class pmr_allocator {
+public:
+	pmr_allocator(std::pmr::memory_resource * resource = std::pmr::get_default_resource()) :
+			resource(resource) {
+	}
+
+	//! Returns 0, like the other allocators, when the resource
+	//! throws std::bad_alloc: the string then truncates
+	char * allocate(int n) {
+		try {
+			return static_cast<char *>(resource->allocate(n, 1));
+		} catch (const std::bad_alloc &) {
+			return 0;
+		}
+	}
+
+	void deallocate(char * p, int n) {
+		resource->deallocate(p, n, 1);
+	}
+
+private:
+	std::pmr::memory_resource * resource;
+};
+#endif
+
+template<int N, typename Allocator> class hybrid_string;
+
+//! true for hybrid_strings of any length and allocator
+template<typename T>
+struct is_hybrid: std::false_type {
+};
+
+template<int N, typename A>
+struct is_hybrid<hybrid_string<N, A> > : std::true_type {
+};
+
+//! enable_if for the forwarding members of hybrid_string, which
+//! must leave hybrid_strings to their own overloads
+template<typename T, typename R>
+struct if_not_hybrid: std::enable_if<
+		!is_hybrid<typename std::decay<T>::type>::value, R> {
+};
+
+//! @brief fixed_string<N> that spills to an allocator past N characters
+//! @details
+//! Usage:
+//! \code
+//! hybrid_string<64> field("id=");
+//! field += value;            // inline while it fits in 64 characters,
+//!                            // from pool_allocator<> when it does not
+//! field.edit([](fixed_string<0> & s) { s.trim(); });
+//! send(field.c_str(), field.get_used_length());
+//! \endcode
+//! Up to N characters the string lives inside the object, exactly like
+//! a fixed_string<N>. An append that does not fit moves it to a buffer
+//! of the allocator, twice as large at least (and a power of two), and
+//! the string stays there until shrink_to_fit() or destruction. Only
+//! when the allocator has no buffer to give does it truncate.
+//! The allocator is any class with char * allocate(int bytes) and
+//! void deallocate(char *, int bytes): pool_allocator (the default,
+//! no heap), heap_allocator or, compiled as C++17, pmr_allocator.
+//! All members of fixed_string<0> are reached through edit() and str();
+//! edit() works within the current capacity, see reserve().
+template<int N, typename Allocator = pool_allocator<> >
+class hybrid_string {
+public:
+	hybrid_string() :
+			heap(0), heap_bytes(0), allocator() {
+		seat(contents, N + 1, 0);
+	}
+
+	explicit hybrid_string(const Allocator & allocator) :
+			heap(0), heap_bytes(0), allocator(allocator) {
+		seat(contents, N + 1, 0);
+	}
+
+	//! Constructor with char, char *, literals, fixed_strings and
+	//! std::strings
+	template<typename T>
+	hybrid_string(T && rhs, const Allocator & allocator = Allocator(),
+			typename if_not_hybrid<T, int>::type = 0,
+			typename std::enable_if<!std::is_same<typename std::decay<T>::type, Allocator>::value>::type * = 0) :
+			heap(0), heap_bytes(0), allocator(allocator) {
+		seat(contents, N + 1, 0);
+		*this += std::forward<T>(rhs);
+	}
+
+	hybrid_string(const hybrid_string & rhs) :
+			heap(0), heap_bytes(0), allocator(rhs.allocator) {
+		seat(contents, N + 1, 0);
+		append(rhs.begin(), rhs.get_used_length());
+	}
+
+	//! Copies a hybrid_string of another length or allocator
+	template<int M, typename A>
+	hybrid_string(const hybrid_string<M, A> & rhs, const Allocator & allocator = Allocator()) :
+			heap(0), heap_bytes(0), allocator(allocator) {
+		seat(contents, N + 1, 0);
+		append(rhs.begin(), rhs.get_used_length());
+	}
+
+	//! Takes over the buffer of a spilled rhs, which is left empty
+	hybrid_string(hybrid_string && rhs) :
+			heap(0), heap_bytes(0), allocator(rhs.allocator) {
+		if (rhs.heap) {
+			heap = rhs.heap;
+			heap_bytes = rhs.heap_bytes;
+			seat(heap, heap_bytes, rhs.get_used_length());
+			rhs.heap = 0;
+			rhs.heap_bytes = 0;
+			rhs.seat(rhs.contents, N + 1, 0);
+		} else {
+			seat(contents, N + 1, 0);
+			append(rhs.begin(), rhs.get_used_length());
+		}
+	}
+
+	~hybrid_string() {
+		if (heap)
+			allocator.deallocate(heap, heap_bytes);
+	}
+
+	hybrid_string & operator=(const hybrid_string & rhs) {
+		if (this != &rhs) {
+			clear();
+			append(rhs.begin(), rhs.get_used_length());
+		}
+		return *this;
+	}
+
+	hybrid_string & operator=(hybrid_string && rhs) {
+		if (this != &rhs) {
+			if (rhs.heap) {
+				if (heap)
+					allocator.deallocate(heap, heap_bytes);
+				std::swap(allocator, rhs.allocator);
+				heap = rhs.heap;
+				heap_bytes = rhs.heap_bytes;
+				seat(heap, heap_bytes, rhs.get_used_length());
+				rhs.heap = 0;
+				rhs.heap_bytes = 0;
+				rhs.seat(rhs.contents, N + 1, 0);
+			} else {
+				clear();
+				append(rhs.begin(), rhs.get_used_length());
+			}
+		}
+		return *this;
+	}
+
+	//! Assigns a char, char *, literal, fixed_string or std::string
+	template<typename T>
+	typename if_not_hybrid<T, hybrid_string &>::type operator=(T && rhs) {
+		clear();
+		return *this += std::forward<T>(rhs);
+	}
+
+	template<int M, typename A>
+	hybrid_string & operator=(const hybrid_string<M, A> & rhs) {
+		clear();
+		append(rhs.begin(), rhs.get_used_length());
+		return *this;
+	}
+
+	//! Appends a single character
+	hybrid_string & operator+=(char c) {
+		reserve(get_used_length() + 1);
+		str_() += c;
+		return *this;
+	}
+
+	//! Appends a char * (one strlen())
+	template<typename P>
+	typename if_char_pointer<P, hybrid_string &>::type operator+=(P rhs) {
+		append(rhs, std::strlen(rhs));
+		return *this;
+	}
+
+	//! Appends a literal or char array; room is made for the whole
+	//! array, fixed_string decides how much of it is the string
+	template<typename C, int K>
+	typename if_char<C, hybrid_string &>::type operator+=(C (&rhs)[K]) {
+		reserve(get_used_length() + K - 1);
+		str_() += rhs;
+		return *this;
+	}
+
+	hybrid_string & operator+=(const fixed_string<0> & rhs) {
+		append(rhs.begin(), rhs.get_used_length());
+		return *this;
+	}
+
+	template<int M, typename A>
+	hybrid_string & operator+=(const hybrid_string<M, A> & rhs) {
+		append(rhs.begin(), rhs.get_used_length());
+		return *this;
+	}
+
+	hybrid_string & operator+=(const std::string & rhs) {
+		append(rhs.data(), rhs.size());
+		return *this;
+	}
+
+#if __cplusplus >= 201703L
+	hybrid_string & operator+=(std::string_view rhs) {
+		append(rhs.data(), rhs.size());
+		return *this;
+	}
+#endif
+
+	//! Appends len characters starting at s
+	//! Appends len characters starting at s; s may point into
+	//! the string itself, which grow() may move
+	void append(const char * s, int len) {
+		const uintptr_t p = reinterpret_cast<uintptr_t>(s);
+		const uintptr_t b = reinterpret_cast<uintptr_t>(begin());
+		if (p >= b && p <= b + get_capacity()) {
+			const int offset = int(p - b);
+			reserve(get_used_length() + len);
+			s = begin() + offset;
+		} else
+			reserve(get_used_length() + len);
+		str_().append(s, len);
+	}
+
+	//! Empties the string; a spilled string keeps its buffer
+	void clear() {
+		str_() = "";
+	}
+
+	//! Makes room for n characters; returns false if the allocator
+	//! could not, in which case the capacity is unchanged
+	bool reserve(int n) {
+		if (n <= get_capacity())
+			return true;
+		return grow(n);
+	}
+
+	//! Moves a spilled string back inside the object if it fits
+	void shrink_to_fit() {
+		const int used = get_used_length();
+		if (heap && used <= N) {
+			std::memcpy(contents, heap, used);
+			seat(contents, N + 1, used);
+			allocator.deallocate(heap, heap_bytes);
+			heap = 0;
+			heap_bytes = 0;
+		}
+	}
+
+	//! Calls f with the string as fixed_string<0> &, for all its other
+	//! members (trim(), replace_all(), ...), within the current capacity
+	template<typename F>
+	void edit(F f) {
+		f(str_());
+	}
+
+	//! The string as fixed_string<0>, read-only
+	const fixed_string<0> & str() const {
+		return *view();
+	}
+
+	operator const fixed_string<0> &() const {
+		return str();
+	}
+
+	//! true while the string lives inside the object
+	bool is_inline() const {
+		return heap == 0;
+	}
+
+	//! Number of characters that fit without growing
+	int get_capacity() const {
+		return heap ? heap_bytes - 1 : N;
+	}
+
+	const char * c_str() const {
+		return str().c_str();
+	}
+
+	int get_used_length() const {
+		return str().get_used_length();
+	}
+
+	int get_allocated_length() const {
+		return str().get_allocated_length();
+	}
+
+	char operator[](int n) const {
+		return str()[n];
+	}
+
+	const char * begin() const {
+		return str().begin();
+	}
+
+	const char * end() const {
+		return str().end();
+	}
+
+#if __cplusplus >= 201703L
+	//! Not a conversion operator as well: that would make
+	//! constructing a fixed_string from a hybrid_string ambiguous
+	std::string_view as_view() const {
+		return str().as_view();
+	}
+#endif
+
+	//! Comparisons with hybrid_strings of any length and allocator
+	template<int M, typename A>
+	bool operator==(const hybrid_string<M, A> & rhs) const {
+		return str() == rhs.str();
+	}
+
+	template<int M, typename A>
+	bool operator!=(const hybrid_string<M, A> & rhs) const {
+		return str() != rhs.str();
+	}
+
+	template<int M, typename A>
+	bool operator<(const hybrid_string<M, A> & rhs) const {
+		return str() < rhs.str();
+	}
+
+	template<int M, typename A>
+	bool operator<=(const hybrid_string<M, A> & rhs) const {
+		return str() <= rhs.str();
+	}
+
+	template<int M, typename A>
+	bool operator>(const hybrid_string<M, A> & rhs) const {
+		return str() > rhs.str();
+	}
+
+	template<int M, typename A>
+	bool operator>=(const hybrid_string<M, A> & rhs) const {
+		return str() >= rhs.str();
+	}
+
+	//! Comparisons with everything else are those of fixed_string
+	template<typename T>
+	typename if_not_hybrid<T, bool>::type operator==(T && rhs) const {
+		return str() == std::forward<T>(rhs);
+	}
+
+	template<typename T>
+	typename if_not_hybrid<T, bool>::type operator!=(T && rhs) const {
+		return str() != std::forward<T>(rhs);
+	}
+
+	template<typename T>
+	typename if_not_hybrid<T, bool>::type operator<(T && rhs) const {
+		return str() < std::forward<T>(rhs);
+	}
+
+	template<typename T>
+	typename if_not_hybrid<T, bool>::type operator<=(T && rhs) const {
+		return str() <= std::forward<T>(rhs);
+	}
+
+	template<typename T>
+	typename if_not_hybrid<T, bool>::type operator>(T && rhs) const {
+		return str() > std::forward<T>(rhs);
+	}
+
+	template<typename T>
+	typename if_not_hybrid<T, bool>::type operator>=(T && rhs) const {
+		return str() >= std::forward<T>(rhs);
+	}
+
+private:
+	//! fixed_string<0> over the current buffer; made again whenever
+	//! the string moves, as its capacity cannot change
+	class hybrid_view: public fixed_string<0> {
+	public:
+		hybrid_view(char * content, int l, int used) :
+				fixed_string<0>(content, l) {
+			set_used_length(used);
+		}
+	};
+
+	//! Makes the view over the l bytes at p, of which the first used
+	//! characters are the string already
+	void seat(char * p, int l, int used) {
+		// the constructor of fixed_string<0> clears the first character
+		const char first = p[0];
+		new (&storage) hybrid_view(p, l, used);
+		p[0] = first;
+		p[used] = '\0';
+	}
+
+	//! Moves the string to a buffer for at least n characters
+	bool grow(int n) {
+		int bytes = 32;
+		while (bytes < 2 * (get_capacity() + 1) || bytes < n + 1)
+			bytes *= 2;
+		char * p = allocator.allocate(bytes);
+		if (p == 0)
+			return false;
+		const int used = get_used_length();
+		std::memcpy(p, begin(), used);
+		if (heap)
+			allocator.deallocate(heap, heap_bytes);
+		heap = p;
+		heap_bytes = bytes;
+		seat(heap, heap_bytes, used);
+		return true;
+	}
+
+	hybrid_view * view() const {
+		return reinterpret_cast<hybrid_view *>(const_cast<typename std::aligned_storage<sizeof(hybrid_view),
+				alignof(hybrid_view)>::type *>(&storage));
+	}
+
+	fixed_string<0> & str_() {
+		return *view();
+	}
+
+	//! the string while it fits; also what the view is made over
+	char contents[N + 1];
+	typename std::aligned_storage<sizeof(hybrid_view), alignof(hybrid_view)>::type storage;
+	char * heap;
+	int heap_bytes;
+	Allocator allocator;
+};
+
+} // namespace fixed_string
+
+namespace std {
+
+//! std::hash for hybrid_strings, the same as for fixed_strings
+template<int N, typename A>
+struct hash< ::fixed_string::hybrid_string<N, A> > {
+	size_t operator()(const ::fixed_string::hybrid_string<N, A> & s) const {
+		return s.str().hash();
+	}
+};
+
+} // namespace std
+#endif /* FIXED_STRING_HYBRID_HPP_ */
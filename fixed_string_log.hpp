@@ -0,0 +1,313 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_log.hpp
+ *
+ *  An asynchronous logger without heap allocations: the logging
+ *  threads format their records straight into the fixed_string slots
+ *  of a ring, and a background thread writes the finished slots to a
+ *  file descriptor, many records per writev() call. Memory use is the
+ *  ring, decided at compile time. POSIX only.
+ */
+
+#ifndef FIXED_STRING_LOG_HPP_
+#define FIXED_STRING_LOG_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+
+//! @brief heap-free asynchronous logger with a ring of Slots records of
+//! up to N characters
+//! @details
+//! Usage:
+//! \code
+//! static fixed_string_logger<256, 1024> log(STDERR_FILENO);
+//! log.log("started");
+//! log.log([&](fixed_string<0> & r) {
+//!		append_timestamp(r, std::chrono::system_clock::now());
+//!		r += " request ";
+//!		r += path;
+//! });
+//! \endcode
+//! Every record becomes one line: a '\n' is added, and a record that
+//! is too long is cut to make room for it. When the ring is full, the
+//! policy decides: drop discards the record (and counts it), block
+//! waits until the writer has freed a slot.
+//! Any number of threads may log at the same time; the ring is a
+//! bounded multi-producer queue where each slot carries a sequence
+//! number, so logging threads never take a lock.
+//! Constructed with background = false, no thread is started and
+//! drain() must be called to write the records; a full ring is then
+//! drained by the logging thread itself under the block policy.
+template<int N, int Slots>
+class fixed_string_logger {
+public:
+	static_assert(Slots >= 2 && (Slots & (Slots - 1)) == 0, "Slots must be a power of two");
+
+	//! what log() does when the ring is full
+	enum full_policy {
+		drop, block
+	};
+
+	//! the most records written by one writev()
+	static const int max_batch = 64;
+
+	explicit fixed_string_logger(int fd, full_policy policy = drop, bool background = true) :
+			fd(fd), policy(policy), stop(false), background(background) {
+		head.store(0);
+		tail = 0;
+		dropped.store(0);
+		written.store(0);
+		sleeping.store(false);
+		for (int i = 0; i < Slots; i++)
+			ring[i].sequence.store(i);
+		if (background)
+			writer = std::thread(&fixed_string_logger::run, this);
+	}
+
+	//! writes the records still in the ring, then stops the writer
+	~fixed_string_logger() {
+		if (background) {
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				stop = true;
+			}
+			wake.notify_one();
+			writer.join();
+		}
+		while (drain() > 0) {
+		}
+	}
+
+	//! Calls f(fixed_string<0> & record) to format a record in a free
+	//! slot. Returns false if the record was dropped. If f throws, the
+	//! exception is passed on and the record counts as dropped; its
+	//! slot is released all the same, so the ring does not stall.
+	template<typename F>
+	typename if_not_fixed_string<F, bool>::type log(F f) {
+		uint64_t pos = head.load(std::memory_order_relaxed);
+		slot * s;
+		for (;;) {
+			s = &ring[pos & (Slots - 1)];
+			const uint64_t seq = s->sequence.load(std::memory_order_acquire);
+			const int64_t diff = int64_t(seq) - int64_t(pos);
+			if (diff == 0) {
+				if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (diff < 0) {
+				// full: the writer has not freed this slot yet
+				if (policy == drop) {
+					dropped.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+				if (background) {
+					wake.notify_one();
+					std::this_thread::yield();
+				} else
+					drain();
+				pos = head.load(std::memory_order_relaxed);
+			} else
+				pos = head.load(std::memory_order_relaxed);
+		}
+		{
+			publisher p = { *this, *s, pos, false };
+			s->record = "";
+			f(static_cast<fixed_string<0> &>(s->record));
+			if (s->record.get_used_length() == N)
+				s->record.truncate(N - 1);
+			s->record += '\n';
+			p.finished = true;
+		}
+		if (background && sleeping.load(std::memory_order_relaxed))
+			wake.notify_one();
+		return true;
+	}
+
+	//! Logs the len characters starting at s
+	bool log(const char * s, int len) {
+		return log([s, len](fixed_string<0> & r) {
+			r.append(s, len);
+		});
+	}
+
+	//! Logs a char * or fixed_string
+	bool log(const char * s) {
+		return log(s, std::strlen(s));
+	}
+
+	bool log(const fixed_string<0> & fs) {
+		return log(fs.begin(), fs.get_used_length());
+	}
+
+	//! Writes the finished records at the front of the ring, at most
+	//! max_batch of them with one writev(), and returns how many.
+	//! Called by the writer thread; without one, by the user.
+	int drain() {
+		std::lock_guard<std::mutex> guard(drain_lock);
+		struct iovec iov[max_batch];
+		// records whose formatting threw are empty: they take no
+		// room in the writev() and are not counted as written
+		int n = 0;
+		while (n < max_batch) {
+			slot & s = ring[(tail + n) & (Slots - 1)];
+			if (s.sequence.load(std::memory_order_acquire) != tail + n + 1)
+				break;
+			iov[n].iov_base = const_cast<char *>(s.record.c_str());
+			iov[n].iov_len = s.record.get_used_length();
+			n++;
+		}
+		if (n == 0)
+			return 0;
+		write_all(iov, n);
+		int empty = 0;
+		for (int i = 0; i < n; i++) {
+			empty += iov[i].iov_len == 0;
+			ring[(tail + i) & (Slots - 1)].sequence.store(tail + i + Slots, std::memory_order_release);
+		}
+		tail += n;
+		written.fetch_add(n - empty, std::memory_order_relaxed);
+		return n;
+	}
+
+	//! Waits until every record logged before the call is written
+	void flush() {
+		const uint64_t target = head.load(std::memory_order_acquire);
+		for (;;) {
+			{
+				std::lock_guard<std::mutex> guard(drain_lock);
+				if (tail >= target)
+					return;
+			}
+			if (background) {
+				wake.notify_one();
+				std::this_thread::yield();
+			} else
+				drain();
+		}
+	}
+
+	//! Returns the number of records dropped because the ring was full
+	uint64_t get_dropped() const {
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+	//! Returns the number of records written
+	uint64_t get_written() const {
+		return written.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct slot {
+		//! pos + 1 once the record of ring position pos is
+		//! finished, pos + Slots once it is written
+		std::atomic<uint64_t> sequence;
+		fixed_string<N> record;
+	};
+
+	//! hands the slot of a record over to the writer when log()
+	//! leaves, also by an exception: an unfinished record is
+	//! emptied (a finished one ends in '\n') and counted as dropped
+	struct publisher {
+		fixed_string_logger & logger;
+		slot & s;
+		const uint64_t pos;
+		bool finished;
+
+		~publisher() {
+			if (!finished) {
+				s.record = "";
+				logger.dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+			s.sequence.store(pos + 1, std::memory_order_release);
+		}
+	};
+
+	//! writev()s all of iov, continuing after short writes;
+	//! gives up on errors other than EINTR
+	void write_all(struct iovec * iov, int n) {
+		while (n > 0) {
+			const ssize_t w = ::writev(fd, iov, n);
+			if (w < 0) {
+				if (errno == EINTR)
+					continue;
+				return;
+			}
+			size_t left = w;
+			while (n > 0 && left >= iov->iov_len) {
+				left -= iov->iov_len;
+				iov++;
+				n--;
+			}
+			if (n > 0) {
+				iov->iov_base = static_cast<char *>(iov->iov_base) + left;
+				iov->iov_len -= left;
+			}
+		}
+	}
+
+	//! the writer thread: drains the ring, and sleeps while it is
+	//! empty (logging threads wake it, else it looks every ms)
+	void run() {
+		for (;;) {
+			if (drain() > 0)
+				continue;
+			std::unique_lock<std::mutex> guard(lock);
+			if (stop)
+				return;
+			sleeping.store(true);
+			wake.wait_for(guard, std::chrono::milliseconds(1));
+			sleeping.store(false);
+		}
+	}
+
+	slot ring[Slots];
+	//! next position to log to, taken by the logging threads
+	std::atomic<uint64_t> head;
+	//! next position to write, only used under drain_lock
+	uint64_t tail;
+	std::atomic<uint64_t> dropped;
+	std::atomic<uint64_t> written;
+	std::atomic<bool> sleeping;
+
+	const int fd;
+	const full_policy policy;
+	std::mutex lock;
+	std::mutex drain_lock;
+	std::condition_variable wake;
+	bool stop;
+	const bool background;
+	std::thread writer;
+};
+
+} // namespace fixed_string
+#endif /* FIXED_STRING_LOG_HPP_ */
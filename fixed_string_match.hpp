@@ -0,0 +1,152 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_match.hpp
+ *
+ *  Shell-style glob matching ('*' and '?') for fixed_strings. Patterns
+ *  known at compile time are split into a literal prefix, a literal
+ *  suffix and a wildcard middle while compiling, so matching a key
+ *  mostly comes down to two memcmp calls of constant length.
+ */
+
+#ifndef FIXED_STRING_MATCH_HPP_
+#define FIXED_STRING_MATCH_HPP_
+
+#include <cstring>
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+namespace glob {
+
+//! returns true for the characters with a special meaning
+constexpr bool is_wildcard(char c) {
+	return c == '*' || c == '?';
+}
+
+//! length of a pattern (constexpr strlen)
+constexpr int length(const char * p, int i = 0) {
+	return p[i] == '\0' ? i : length(p, i + 1);
+}
+
+//! number of literal characters before the first wildcard
+constexpr int prefix_length(const char * p, int i = 0) {
+	return (p[i] == '\0' || is_wildcard(p[i])) ? i : prefix_length(p, i + 1);
+}
+
+//! position of the last wildcard before position i, or -1
+constexpr int last_wildcard(const char * p, int i) {
+	return i < 0 ? -1 : (is_wildcard(p[i]) ? i : last_wildcard(p, i - 1));
+}
+
+//! returns true if the pattern contains a '*'
+constexpr bool has_star(const char * p, int i = 0) {
+	return p[i] == '\0' ? false : (p[i] == '*' || has_star(p, i + 1));
+}
+
+//! returns true if the first len characters of p are all '*'
+constexpr bool all_stars(const char * p, int len) {
+	return len == 0 ? true : (p[len - 1] == '*' && all_stars(p, len - 1));
+}
+
+//! Matches the pattern [p, p + plen) against [s, s + slen).
+//! '*' matches any sequence (also empty), '?' matches any one
+//! character, every other character only matches itself.
+//! On a mismatch after a '*', the match is retried from the
+//! character after the one the '*' last started at, which
+//! never revisits earlier stars.
+inline bool match(const char * p, int plen, const char * s, int slen) {
+	int pi = 0, si = 0;
+	int star = -1, star_si = 0;
+	while (si < slen) {
+		if (pi < plen && p[pi] == '*') {
+			star = pi++;
+			star_si = si;
+		} else if (pi < plen && (p[pi] == '?' || p[pi] == s[si])) {
+			pi++;
+			si++;
+		} else if (star >= 0) {
+			pi = star + 1;
+			si = ++star_si;
+		} else {
+			return false;
+		}
+	}
+	while (pi < plen && p[pi] == '*')
+		pi++;
+	return pi == plen;
+}
+
+//! @brief glob pattern analysed at compile time
+//! @details
+//! The pattern has to be a constexpr char array with linkage:
+//! \code
+//! constexpr char latency_keys[] = "metrics.*.latency";
+//! if (fixed_string::match<latency_keys>(key)) { }
+//! \endcode
+//! Matching checks the length, the literal prefix and the literal
+//! suffix first; only the part between the first and the last
+//! wildcard is handed to the generic matcher.
+template<const char * P>
+struct pattern {
+	static constexpr int length = glob::length(P);
+	static constexpr int prefix = glob::prefix_length(P);
+	static constexpr int suffix = length - 1 - last_wildcard(P, length - 1);
+	static constexpr bool star = has_star(P);
+	//! the wildcard part between prefix and suffix
+	static constexpr int middle = length - prefix - (prefix == length ? 0 : suffix);
+	static constexpr bool middle_all_stars = all_stars(P + prefix, middle);
+
+	static bool matches(const char * s, int slen) {
+		if (star ? slen < length - middle : slen != length)
+			return false;
+		if (std::memcmp(s, P, prefix) != 0)
+			return false;
+		if (prefix == length)
+			return true;
+		if (std::memcmp(s + slen - suffix, P + length - suffix, suffix) != 0)
+			return false;
+		if (middle_all_stars)
+			return true;
+		return glob::match(P + prefix, middle, s + prefix, slen - prefix - suffix);
+	}
+};
+
+} // namespace glob
+
+//! Returns true if fs matches the compile-time glob pattern P.
+//! See glob::pattern.
+template<const char * P>
+inline bool match(const fixed_string<0> & fs) {
+	return glob::pattern<P>::matches(fs.c_str(), fs.get_used_length());
+}
+
+//! Returns true if fs matches the glob pattern, which is
+//! interpreted at runtime. Use match<P>(fs) when the pattern
+//! is known at compile time.
+inline bool match(const char * pattern, const fixed_string<0> & fs) {
+	return glob::match(pattern, std::strlen(pattern), fs.c_str(),
+			fs.get_used_length());
+}
+
+} // namespace fixed_string
+#endif /* FIXED_STRING_MATCH_HPP_ */
@@ -0,0 +1,221 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_serial.hpp
+ *
+ *  Binary wire formats for fixed_strings:
+ *   - varint records: the length as unsigned LEB128 varint, followed
+ *     by the characters (no terminator); 1 byte of overhead up to 127
+ *     characters
+ *   - padded records: the characters in a field of a fixed width,
+ *     padded with '\0'
+ *  Decoding never scans for a terminator in varint records; it either
+ *  copies the characters with one memcpy or returns a view into the
+ *  receive buffer.
+ *  All functions return the number of bytes written or read, or -1 if
+ *  the buffer is too short or the input is malformed.
+ */
+
+#ifndef FIXED_STRING_SERIAL_HPP_
+#define FIXED_STRING_SERIAL_HPP_
+
+#include <cstring>
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+namespace serial {
+
+//! characters of a decoded record, pointing into the receive buffer
+struct view {
+	const char * data;
+	int length;
+};
+
+//! number of bytes of the varint encoding of n
+inline int varint_size(unsigned int n) {
+	int size = 1;
+	while (n >= 0x80) {
+		n >>= 7;
+		size++;
+	}
+	return size;
+}
+
+//! writes n as varint to out; returns the number of bytes or -1
+inline int write_varint(unsigned int n, char * out, int out_len) {
+	int i = 0;
+	do {
+		if (i == out_len)
+			return -1;
+		const unsigned char b = n & 0x7F;
+		n >>= 7;
+		out[i++] = n ? (b | 0x80) : b;
+	} while (n);
+	return i;
+}
+
+//! reads a varint of at most 5 bytes; returns the number of bytes or -1,
+//! also if the value does not fit in 32 bits
+inline int read_varint(const char * in, int in_len, unsigned int & n) {
+	n = 0;
+	for (int i = 0; i < in_len && i < 5; i++) {
+		const unsigned char b = in[i];
+		// the fifth byte holds bits 28 - 31 only
+		if (i == 4 && (b & 0x70))
+			return -1;
+		n |= static_cast<unsigned int>(b & 0x7F) << (7 * i);
+		if ((b & 0x80) == 0)
+			return i + 1;
+	}
+	return -1;
+}
+
+//! number of bytes encode() writes for fs
+inline int encoded_size(const fixed_string<0> & fs) {
+	return varint_size(fs.get_used_length()) + fs.get_used_length();
+}
+
+//! Writes fs as varint record
+inline int encode(const fixed_string<0> & fs, char * out, int out_len) {
+	const int len = fs.get_used_length();
+	const int header = write_varint(len, out, out_len);
+	if (header < 0 || len > out_len - header)
+		return -1;
+	std::memcpy(out + header, fs.c_str(), len);
+	return header + len;
+}
+
+//! Reads a varint record without copying: v points into in
+inline int decode(const char * in, int in_len, view & v) {
+	unsigned int len;
+	const int header = read_varint(in, in_len, len);
+	if (header < 0 || len > static_cast<unsigned int>(in_len - header))
+		return -1;
+	v.data = in + header;
+	v.length = len;
+	return header + len;
+}
+
+//! Reads a varint record into fs with one memcpy; characters that
+//! do not fit in fs are discarded like with operator=
+inline int decode(const char * in, int in_len, fixed_string<0> & fs) {
+	view v;
+	const int n = decode(in, in_len, v);
+	if (n >= 0)
+		fs.assign(v.data, v.length);
+	return n;
+}
+
+//! Writes fs in a field of width bytes, padded with '\0'. A string
+//! of exactly width characters has no terminator in the field.
+inline int encode_padded(const fixed_string<0> & fs, char * out, int width) {
+	const int len = fs.get_used_length();
+	if (width < 0 || len > width)
+		return -1;
+	std::memcpy(out, fs.c_str(), len);
+	std::memset(out + len, 0, width - len);
+	return width;
+}
+
+//! Reads a field of width bytes written by encode_padded()
+inline int decode_padded(const char * in, int width, view & v) {
+	if (width < 0)
+		return -1;
+	const char * end = static_cast<const char *>(std::memchr(in, '\0', width));
+	v.data = in;
+	v.length = end ? end - in : width;
+	return width;
+}
+
+inline int decode_padded(const char * in, int width, fixed_string<0> & fs) {
+	view v;
+	if (decode_padded(in, width, v) < 0)
+		return -1;
+	fs.assign(v.data, v.length);
+	return width;
+}
+
+//! Writes count strings as consecutive varint records
+template<typename T>
+int encode_all(const T * strings, int count, char * out, int out_len) {
+	int pos = 0;
+	for (int i = 0; i < count; i++) {
+		const int n = encode(strings[i], out + pos, out_len - pos);
+		if (n < 0)
+			return -1;
+		pos += n;
+	}
+	return pos;
+}
+
+//! Reads count consecutive varint records into strings
+template<typename T>
+int decode_all(const char * in, int in_len, T * strings, int count) {
+	int pos = 0;
+	for (int i = 0; i < count; i++) {
+		const int n = decode(in + pos, in_len - pos, strings[i]);
+		if (n < 0)
+			return -1;
+		pos += n;
+	}
+	return pos;
+}
+
+//! Reads count consecutive varint records as views into in
+inline int decode_all(const char * in, int in_len, view * views, int count) {
+	int pos = 0;
+	for (int i = 0; i < count; i++) {
+		const int n = decode(in + pos, in_len - pos, views[i]);
+		if (n < 0)
+			return -1;
+		pos += n;
+	}
+	return pos;
+}
+
+//! Writes count strings as padded records of width bytes each;
+//! -1 if width is not positive
+template<typename T>
+int encode_all_padded(const T * strings, int count, char * out, int out_len, int width) {
+	if (width <= 0 || count > out_len / width)
+		return -1;
+	for (int i = 0; i < count; i++)
+		if (encode_padded(strings[i], out + i * width, width) < 0)
+			return -1;
+	return count * width;
+}
+
+//! Reads count padded records of width bytes each into strings;
+//! -1 if width is not positive
+template<typename T>
+int decode_all_padded(const char * in, int in_len, T * strings, int count, int width) {
+	if (width <= 0 || count > in_len / width)
+		return -1;
+	for (int i = 0; i < count; i++)
+		decode_padded(in + i * width, width, strings[i]);
+	return count * width;
+}
+
+} // namespace serial
+} // namespace fixed_string
+#endif /* FIXED_STRING_SERIAL_HPP_ */
@@ -0,0 +1,236 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_sorted_set.hpp
+ *
+ *  A sorted, immutable set of fixed_strings for ordered lookups. The
+ *  search runs over the first 8 characters of every element, packed
+ *  big-endian into a uint64_t so that integer order is string order,
+ *  laid out in Eytzinger (breadth-first) order so the search is
+ *  branchless and cache friendly. Characters beyond the first 8 are
+ *  only compared when two of those integers are equal.
+ */
+
+#ifndef FIXED_STRING_SORTED_SET_HPP_
+#define FIXED_STRING_SORTED_SET_HPP_
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <stdint.h>
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+
+//! @brief sorted set of up to MaxElements fixed_string<N>, built in one go
+//! @details
+//! Usage:
+//! \code
+//! static sorted_fixed_string_set<32, 100000> symbols;
+//! symbols.build(names, count);          // any order, duplicates allowed
+//! if (symbols.contains("main")) { }
+//! std::pair<int, int> r = symbols.range("std::", "std:;");
+//! for (int i = r.first; i < r.second; i++)
+//!		use(symbols[i]);
+//! \endcode
+//! Elements are addressed by their index in sorted order, so range
+//! queries return a pair of indices [first, last). Characters compare
+//! as unsigned bytes, the order of std::string.
+template<int N, int MaxElements>
+class sorted_fixed_string_set {
+public:
+	static_assert(MaxElements > 0, "the set needs room for an element");
+
+	sorted_fixed_string_set() :
+			count(0) {
+	}
+
+	//! Replaces the contents by the strings of the array, in any order
+	//! (fixed_strings of any length). Strings longer than N are cut, and
+	//! duplicates are stored once. Returns the number of elements, or -1
+	//! (leaving the set empty) if n is larger than MaxElements.
+	template<typename T>
+	int build(const T * strings, int n) {
+		count = 0;
+		if (n < 0 || n > MaxElements)
+			return -1;
+		// cut first: a cut can change the order (UTF8SAFETRUNCATION
+		// may drop more than the characters beyond N)
+		for (int i = 0; i < n; i++)
+			elements[i] = strings[i];
+		std::sort(elements, elements + n, [](const fixed_string<N> & a, const fixed_string<N> & b) {
+			return compare(a.begin(), a.get_used_length(), b.begin(), b.get_used_length()) < 0;
+		});
+		for (int i = 0; i < n; i++)
+			if (count == 0 || !(elements[i] == elements[count - 1])) {
+				if (count != i)
+					elements[count] = elements[i];
+				count++;
+			}
+		int next = 0;
+		fill(1, next);
+		return count;
+	}
+
+	//! Returns the number of elements
+	int size() const {
+		return count;
+	}
+
+	//! Returns the i'th element in sorted order
+	const fixed_string<N> & operator[](int i) const {
+		return elements[i];
+	}
+
+	//! Returns the index of the first element not less than
+	//! [s, s + len), or size() if there is none
+	int lower_bound(const char * s, int len) const {
+		return search<false>(s, len);
+	}
+
+	int lower_bound(const char * s) const {
+		return lower_bound(s, std::strlen(s));
+	}
+
+	int lower_bound(const fixed_string<0> & fs) const {
+		return lower_bound(fs.begin(), fs.get_used_length());
+	}
+
+	//! Returns the index of the first element greater than
+	//! [s, s + len), or size() if there is none
+	int upper_bound(const char * s, int len) const {
+		return search<true>(s, len);
+	}
+
+	int upper_bound(const char * s) const {
+		return upper_bound(s, std::strlen(s));
+	}
+
+	int upper_bound(const fixed_string<0> & fs) const {
+		return upper_bound(fs.begin(), fs.get_used_length());
+	}
+
+	//! Returns true if [s, s + len) is an element
+	bool contains(const char * s, int len) const {
+		const int i = lower_bound(s, len);
+		return i < count && compare(elements[i].begin(), elements[i].get_used_length(), s, len) == 0;
+	}
+
+	bool contains(const char * s) const {
+		return contains(s, std::strlen(s));
+	}
+
+	bool contains(const fixed_string<0> & fs) const {
+		return contains(fs.begin(), fs.get_used_length());
+	}
+
+	//! Returns the indices [first, last) of the elements in
+	//! [low, high): not less than low and less than high
+	std::pair<int, int> range(const char * low, int low_len, const char * high, int high_len) const {
+		const int first = lower_bound(low, low_len);
+		const int last = lower_bound(high, high_len);
+		return std::make_pair(first, last < first ? first : last);
+	}
+
+	std::pair<int, int> range(const char * low, const char * high) const {
+		return range(low, std::strlen(low), high, std::strlen(high));
+	}
+
+	std::pair<int, int> range(const fixed_string<0> & low, const fixed_string<0> & high) const {
+		return range(low.begin(), low.get_used_length(), high.begin(), high.get_used_length());
+	}
+
+	//! The first 8 characters of [s, s + len) as big-endian
+	//! integer, padded with zeros
+	static uint64_t prefix(const char * s, int len) {
+		unsigned char b[8] = { 0 };
+		std::memcpy(b, s, len < 8 ? len : 8);
+		return (uint64_t(b[0]) << 56) | (uint64_t(b[1]) << 48) | (uint64_t(b[2]) << 40)
+				| (uint64_t(b[3]) << 32) | (uint64_t(b[4]) << 24) | (uint64_t(b[5]) << 16)
+				| (uint64_t(b[6]) << 8) | uint64_t(b[7]);
+	}
+
+private:
+	//! string order of [a, a + alen) and [b, b + blen): <0, 0 or >0
+	static int compare(const char * a, size_t alen, const char * b, size_t blen) {
+		const int r = std::memcmp(a, b, alen < blen ? alen : blen);
+		if (r != 0)
+			return r;
+		return alen < blen ? -1 : alen > blen;
+	}
+
+	//! Eytzinger search: walks down the implicit tree, going right
+	//! while the element is less than (Upper: not greater than) the
+	//! key, then recovers the last node where it went left. The
+	//! step only depends on the comparison, not on a branch.
+	template<bool Upper>
+	int search(const char * s, int len) const {
+		const uint64_t p = prefix(s, len);
+		int k = 1;
+		while (k <= count) {
+#if defined(__GNUC__)
+			// the node four levels down, which the search reaches soon
+			if (16 * k <= count)
+				__builtin_prefetch(keys + 16 * k);
+#endif
+			bool right = keys[k] < p;
+			if (keys[k] == p) {
+				const fixed_string<N> & e = elements[order[k]];
+				const int c = compare(e.begin(), e.get_used_length(), s, len);
+				right = Upper ? c <= 0 : c < 0;
+			}
+			k = 2 * k + right;
+		}
+		// strip the trailing right turns and the last left turn
+#if defined(__GNUC__)
+		k >>= __builtin_ffs(~k);
+#else
+		while (k & 1)
+			k >>= 1;
+		k >>= 1;
+#endif
+		return k == 0 ? count : order[k];
+	}
+
+	//! stores the sorted elements in Eytzinger order: an in-order walk
+	//! over the implicit tree with the children of k at 2k and 2k + 1
+	void fill(int k, int & next) {
+		if (k > count)
+			return;
+		fill(2 * k, next);
+		keys[k] = prefix(elements[next].begin(), elements[next].get_used_length());
+		order[k] = next++;
+		fill(2 * k + 1, next);
+	}
+
+	//! the elements in sorted order
+	fixed_string<N> elements[MaxElements];
+	//! prefixes in Eytzinger order, from index 1
+	uint64_t keys[MaxElements + 1];
+	//! index of the element of each Eytzinger node
+	int order[MaxElements + 1];
+	int count;
+};
+
+} // namespace fixed_string
+#endif /* FIXED_STRING_SORTED_SET_HPP_ */
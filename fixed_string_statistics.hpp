@@ -0,0 +1,267 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_statistics.hpp
+ *
+ *  Counts, per allocated length, how often fixed_strings run out of
+ *  room, how many characters they drop and how long they get. Only
+ *  compiled in when FIXEDSTRINGSTATISTICS is defined (see defines.hpp),
+ *  so it costs nothing otherwise.
+ *
+ *  Every thread counts in its own table, so recording never takes a
+ *  lock; snapshot() adds up the tables of all threads, including the
+ *  ones that have already finished.
+ */
+
+#ifndef FIXED_STRING_STATISTICS_HPP_
+#define FIXED_STRING_STATISTICS_HPP_
+
+#include <atomic>
+#include <mutex>
+#include <ostream>
+
+namespace fixed_string {
+namespace statistics {
+
+//! number of different allocated lengths tracked; strings of any
+//! further lengths are counted together under allocated_length -1
+static const int max_lengths = 64;
+
+//! the counters of one allocated length, as returned by snapshot()
+struct length_statistics {
+	//! allocated length (N + 1 for fixed_string<N>), or -1 for "other"
+	int allocated_length;
+	//! number of times characters were discarded
+	unsigned long long truncations;
+	//! total number of characters discarded
+	unsigned long long overflowed_bytes;
+	//! longest used length seen
+	int high_water;
+};
+
+//! Counters of one allocated length, kept per thread. Only the owning
+//! thread writes them; the atomics (all relaxed, so plain loads and
+//! stores) let snapshot() read them from another thread.
+struct counters {
+	std::atomic<int> allocated_length;
+	std::atomic<unsigned long long> truncations;
+	std::atomic<unsigned long long> overflowed_bytes;
+	std::atomic<int> high_water;
+};
+
+//! open-addressing table of counters, keyed by allocated length
+class table {
+public:
+	table() {
+		for (int i = 0; i <= max_lengths; i++) {
+			slots[i].allocated_length.store(0, std::memory_order_relaxed);
+			slots[i].truncations.store(0, std::memory_order_relaxed);
+			slots[i].overflowed_bytes.store(0, std::memory_order_relaxed);
+			slots[i].high_water.store(0, std::memory_order_relaxed);
+		}
+		slots[max_lengths].allocated_length.store(-1, std::memory_order_relaxed);
+	}
+
+	//! Returns the counters for allocated_length; claims a free slot
+	//! the first time a length is seen. Must only be called by the
+	//! thread owning the table (or with the registry locked).
+	counters & get(int allocated_length) {
+		int i = allocated_length & (max_lengths - 1);
+		for (int probe = 0; probe < max_lengths; probe++) {
+			const int l = slots[i].allocated_length.load(std::memory_order_relaxed);
+			if (l == allocated_length)
+				return slots[i];
+			if (l == 0) {
+				slots[i].allocated_length.store(allocated_length, std::memory_order_release);
+				return slots[i];
+			}
+			i = (i + 1) & (max_lengths - 1);
+		}
+		return slots[max_lengths];
+	}
+
+	//! adds the counters of this table to the ones in out (which
+	//! holds n entries, and room for capacity) and returns the new
+	//! n; lengths beyond capacity - 1 entries go to "other" (-1)
+	int add_to(length_statistics * out, int n, int capacity) const {
+		for (int i = 0; i <= max_lengths; i++) {
+			const int l = slots[i].allocated_length.load(std::memory_order_acquire);
+			const unsigned long long t = slots[i].truncations.load(std::memory_order_relaxed);
+			const unsigned long long b = slots[i].overflowed_bytes.load(std::memory_order_relaxed);
+			const int h = slots[i].high_water.load(std::memory_order_relaxed);
+			if (l == 0 || (t == 0 && h == 0))
+				continue;
+			int j = find(out, n, l);
+			if (j == n && n >= capacity - 1 && l >= 0)
+				j = find(out, n, -1);
+			if (j == n) {
+				out[n].allocated_length = n < capacity - 1 ? l : -1;
+				out[n].truncations = 0;
+				out[n].overflowed_bytes = 0;
+				out[n].high_water = 0;
+				n++;
+			}
+			out[j].truncations += t;
+			out[j].overflowed_bytes += b;
+			if (h > out[j].high_water)
+				out[j].high_water = h;
+		}
+		return n;
+	}
+
+	//! index of the entry for allocated length l in out, or n
+	static int find(const length_statistics * out, int n, int l) {
+		int j = 0;
+		while (j < n && out[j].allocated_length != l)
+			j++;
+		return j;
+	}
+
+	//! adds the counters of other to this table
+	void merge(const table & other) {
+		for (int i = 0; i <= max_lengths; i++) {
+			const int l = other.slots[i].allocated_length.load(std::memory_order_acquire);
+			if (l == 0)
+				continue;
+			counters & c = (l < 0) ? slots[max_lengths] : get(l);
+			add(c.truncations, other.slots[i].truncations.load(std::memory_order_relaxed));
+			add(c.overflowed_bytes, other.slots[i].overflowed_bytes.load(std::memory_order_relaxed));
+			raise(c.high_water, other.slots[i].high_water.load(std::memory_order_relaxed));
+		}
+	}
+
+	//! increments a counter only written by its own thread
+	static void add(std::atomic<unsigned long long> & c, unsigned long long n) {
+		c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+	//! raises a high-water mark only written by its own thread
+	static void raise(std::atomic<int> & c, int n) {
+		if (n > c.load(std::memory_order_relaxed))
+			c.store(n, std::memory_order_relaxed);
+	}
+
+private:
+	//! max_lengths slots, plus one for "other"
+	counters slots[max_lengths + 1];
+};
+
+class thread_table;
+
+//! lock protecting the list of threads and the finished totals
+inline std::mutex & registry_lock() {
+	static std::mutex lock;
+	return lock;
+}
+
+//! counters of the threads that have finished
+inline table & finished() {
+	static table totals;
+	return totals;
+}
+
+//! head of the list of tables of running threads
+inline thread_table *& running() {
+	static thread_table * head = 0;
+	return head;
+}
+
+//! table of one thread; registers itself while the thread runs,
+//! and adds its counters to finished() when the thread ends
+class thread_table: public table {
+public:
+	thread_table() {
+		std::lock_guard<std::mutex> guard(registry_lock());
+		next = running();
+		running() = this;
+	}
+
+	~thread_table() {
+		std::lock_guard<std::mutex> guard(registry_lock());
+		finished().merge(*this);
+		thread_table ** p = &running();
+		while (*p != this)
+			p = &(*p)->next;
+		*p = next;
+	}
+
+	thread_table * next;
+};
+
+//! the table of the calling thread
+inline table & local() {
+	static thread_local thread_table t;
+	return t;
+}
+
+//! records that a string of allocated_length is now used long
+inline void record_length(int allocated_length, int used) {
+	table::raise(local().get(allocated_length).high_water, used);
+}
+
+//! records that a string of allocated_length discarded dropped characters
+inline void record_truncation(int allocated_length, int dropped) {
+	counters & c = local().get(allocated_length);
+	table::add(c.truncations, 1);
+	table::add(c.overflowed_bytes, dropped);
+}
+
+//! Copies the counters of all threads, added up per allocated length
+//! and sorted by it, into out, which holds capacity (at least 1)
+//! entries. Threads may have seen different lengths: those that do
+//! not fit are added up in the last entry, "other" (-1). Returns the
+//! number of entries written.
+inline int snapshot(length_statistics * out, int capacity = max_lengths + 1) {
+	std::lock_guard<std::mutex> guard(registry_lock());
+	int n = finished().add_to(out, 0, capacity);
+	for (thread_table * t = running(); t; t = t->next)
+		n = t->add_to(out, n, capacity);
+	// insertion sort, "other" (-1) goes last
+	for (int i = 1; i < n; i++) {
+		length_statistics s = out[i];
+		int j = i;
+		while (j > 0 && (s.allocated_length >= 0)
+				&& (out[j - 1].allocated_length < 0
+						|| out[j - 1].allocated_length > s.allocated_length)) {
+			out[j] = out[j - 1];
+			j--;
+		}
+		out[j] = s;
+	}
+	return n;
+}
+
+//! Writes a snapshot as CSV: allocated_length, truncations,
+//! overflowed_bytes, high_water
+inline void print(std::ostream & os) {
+	length_statistics s[max_lengths + 1];
+	const int n = snapshot(s, max_lengths + 1);
+	os << "allocated_length,truncations,overflowed_bytes,high_water\n";
+	for (int i = 0; i < n; i++)
+		os << s[i].allocated_length << ',' << s[i].truncations << ','
+				<< s[i].overflowed_bytes << ',' << s[i].high_water << '\n';
+}
+
+} // namespace statistics
+} // namespace fixed_string
+
+#endif /* FIXED_STRING_STATISTICS_HPP_ */
@@ -0,0 +1,253 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_switch.hpp
+ *
+ *  Maps a fixed_string to the index of one of a constant set of
+ *  keywords with one hash and one compare, using a perfect hash
+ *  (hash and displace) over the keywords.
+ */
+
+#ifndef FIXED_STRING_SWITCH_HPP_
+#define FIXED_STRING_SWITCH_HPP_
+
+#include <cstring>
+#include <stdint.h>
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+
+//! @brief perfect hash table over a constant set of keywords
+//! @details
+//! Usage:
+//! \code
+//! static const char * keywords[] = { "GET", "PUT", "DELETE" };
+//! static const string_table<3> table(keywords);
+//! switch (table.index(fs)) {
+//! case 0: // GET
+//! ...
+//! case -1: // not a keyword
+//! }
+//! \endcode
+//! The keywords are split into buckets by one half of their hash; each
+//! bucket gets a displacement that moves all its keywords into free
+//! slots of a table with at least two slots per keyword. Looking up a
+//! string then takes one hash, one slot and one memcmp.
+//! The keywords are not copied and must outlive the table.
+template<int N>
+class string_table {
+public:
+	static_assert(N > 0 && N <= 32767, "index must fit in 16 bits");
+
+	explicit string_table(const char * const (&words)[N]) :
+			perfect(true) {
+		for (int i = 0; i < N; i++) {
+			keys[i] = words[i];
+			lengths[i] = std::strlen(words[i]);
+			hashes[i] = hash(keys[i], lengths[i]);
+		}
+		build();
+	}
+
+	//! Returns the index of [s, s + len) in the keywords, or -1
+	int index(const char * s, int len) const {
+		if (!perfect)
+			return linear_index(s, len);
+		const uint64_t h = hash(s, len);
+		const int i = table[slot(h, displacement[bucket(h)])];
+		if (i >= 0 && lengths[i] == len && std::memcmp(keys[i], s, len) == 0)
+			return i;
+		return -1;
+	}
+
+	//! Returns the index of the contents of fs in the keywords, or -1
+	int index(const fixed_string<0> & fs) const {
+		return index(fs.c_str(), fs.get_used_length());
+	}
+
+	//! Returns the index of a null-terminated string, or -1
+	int index(const char * s) const {
+		return index(s, std::strlen(s));
+	}
+
+	//! FNV-1a, followed by a finalizer: plain FNV-1a leaves
+	//! the upper half (which selects the bucket) poorly mixed
+	static uint64_t hash(const char * s, int len) {
+		uint64_t h = 14695981039346656037ULL;
+		for (int i = 0; i < len; i++) {
+			h ^= static_cast<unsigned char>(s[i]);
+			h *= 1099511628211ULL;
+		}
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+private:
+	//! smallest power of two >= n
+	static constexpr int pow2(int n, int p = 1) {
+		return p >= n ? p : pow2(n, p * 2);
+	}
+
+	static const int slots = pow2(2 * N);
+	static const int buckets = pow2((N + 1) / 2);
+	//! give up on a bucket after this many displacements
+	static const uint32_t max_displacement = 1 << 16;
+
+	static int bucket(uint64_t h) {
+		return static_cast<uint32_t>(h >> 32) & (buckets - 1);
+	}
+
+	//! mixes the low half of the hash with the displacement
+	static int slot(uint64_t h, uint32_t d) {
+		uint32_t x = static_cast<uint32_t>(h) + d * 0x9E3779B9u;
+		x ^= x >> 16;
+		x *= 0x85EBCA6Bu;
+		x ^= x >> 13;
+		return x & (slots - 1);
+	}
+
+	//! Places the buckets, largest first, each at the first
+	//! displacement for which all its keywords land in free slots.
+	//! Only fails for duplicate keywords; the table then falls
+	//! back to a linear search.
+	void build() {
+		int size[buckets];
+		std::memset(size, 0, sizeof(size));
+		for (int i = 0; i < N; i++)
+			size[bucket(hashes[i])]++;
+		for (int s = 0; s < slots; s++)
+			table[s] = -1;
+		for (int b = 0; b < buckets; b++)
+			displacement[b] = 0;
+
+		for (int largest = N; largest > 0; largest--) {
+			for (int b = 0; b < buckets; b++) {
+				if (size[b] != largest)
+					continue;
+				if (!place(b)) {
+					perfect = false;
+					return;
+				}
+			}
+		}
+	}
+
+	//! finds a displacement for bucket b and fills its slots
+	bool place(int b) {
+		for (uint32_t d = 0; d < max_displacement; d++) {
+			bool free = true;
+			for (int i = 0; i < N && free; i++) {
+				if (bucket(hashes[i]) != b)
+					continue;
+				const int s = slot(hashes[i], d);
+				if (table[s] >= 0) {
+					free = false;
+					break;
+				}
+				// reserve the slot, so keywords of the same bucket
+				// cannot end up in the same slot either
+				table[s] = i;
+			}
+			if (free) {
+				displacement[b] = d;
+				return true;
+			}
+			// undo the reservations made for this displacement
+			for (int i = 0; i < N; i++)
+				if (bucket(hashes[i]) == b && table[slot(hashes[i], d)] == i)
+					table[slot(hashes[i], d)] = -1;
+		}
+		return false;
+	}
+
+	int linear_index(const char * s, int len) const {
+		for (int i = 0; i < N; i++)
+			if (lengths[i] == len && std::memcmp(keys[i], s, len) == 0)
+				return i;
+		return -1;
+	}
+
+	const char * keys[N];
+	int lengths[N];
+	uint64_t hashes[N];
+	uint32_t displacement[buckets];
+	int16_t table[slots];
+	bool perfect;
+};
+
+//! @brief switch over keywords given as template arguments
+//! @details
+//! The keywords have to be constexpr char arrays with linkage:
+//! \code
+//! constexpr char get[] = "GET", put[] = "PUT";
+//! typedef string_switch<get, put> commands;
+//! switch (commands::index(fs)) {
+//! case commands::index_of<get>(): ...
+//! }
+//! \endcode
+//! The table is built once, on first use.
+template<const char * ... Keys>
+class string_switch {
+public:
+	static const int size = sizeof...(Keys);
+
+	//! Returns the index of the contents of fs in Keys, or -1
+	static int index(const fixed_string<0> & fs) {
+		return get_table().index(fs);
+	}
+
+	//! Returns the index of [s, s + len) in Keys, or -1
+	static int index(const char * s, int len) {
+		return get_table().index(s, len);
+	}
+
+	//! Returns the index of keyword K, for use as case label.
+	//! Does not compile if K is not one of Keys.
+	template<const char * K>
+	static constexpr int index_of() {
+		return find(K, 0, Keys...);
+	}
+
+private:
+	static constexpr int find(const char * k, int) {
+		// a throw is not a constant expression: this
+		// stops the compiler when K is not in Keys
+		return k == 0 ? -1 : throw "not a keyword of this string_switch";
+	}
+
+	template<typename ... Rest>
+	static constexpr int find(const char * k, int i, const char * first, Rest ... rest) {
+		return k == first ? i : find(k, i + 1, rest...);
+	}
+
+	static const string_table<sizeof...(Keys)> & get_table() {
+		static const char * const words[] = { Keys... };
+		static const string_table<sizeof...(Keys)> table(words);
+		return table;
+	}
+};
+
+} // namespace fixed_string
+#endif /* FIXED_STRING_SWITCH_HPP_ */
@@ -0,0 +1,155 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_time.hpp
+ *
+ *  Appends ISO-8601 UTC timestamps (2024-05-06T07:08:09.123Z) to
+ *  fixed_strings, for log records. Every thread keeps the text of the
+ *  last second it formatted; while the second stays the same, only
+ *  the fraction is written, eight digits at a time with SWAR
+ *  arithmetic. The output equals that of strftime("%Y-%m-%dT%H:%M:%S")
+ *  on gmtime() followed by snprintf(".%03dZ") (or %06d, %09d).
+ */
+
+#ifndef FIXED_STRING_TIME_HPP_
+#define FIXED_STRING_TIME_HPP_
+
+#include <chrono>
+#include <cstring>
+#include <stdint.h>
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+namespace timestamp {
+
+//! digits of the fraction of a second
+enum precision {
+	seconds = 0, milliseconds = 3, microseconds = 6, nanoseconds = 9
+};
+
+//! Writes v (< 100000000) as eight decimal digits, with leading
+//! zeros, to out. The digits are split in lanes of one 64 bit word:
+//! two lanes of 4 digits, then four of 2, then eight of 1, each
+//! step a multiply by a reciprocal instead of a division.
+inline void write_8_digits(uint32_t v, char * out) {
+	uint64_t x = (v / 10000) | (uint64_t(v % 10000) << 32);
+	// x / 100 per 32 bit lane: (x * 5243) >> 19, exact below 43699
+	uint64_t q = ((x * 5243) >> 19) & 0x0000007F0000007FULL;
+	x = q | ((x - q * 100) << 16);
+	// x / 10 per 16 bit lane: (x * 103) >> 10, exact below 179
+	q = ((x * 103) >> 10) & 0x000F000F000F000FULL;
+	x = q | ((x - q * 10) << 8);
+	x += 0x3030303030303030ULL;
+	// the lowest byte holds the first digit: little-endian order
+	for (int i = 0; i < 8; i++)
+		out[i] = char(x >> (8 * i));
+}
+
+//! Writes v (< 100) as two decimal digits
+inline void write_2_digits(int v, char * out) {
+	out[0] = char('0' + v / 10);
+	out[1] = char('0' + v % 10);
+}
+
+//! Writes the 19 characters YYYY-MM-DDTHH:MM:SS of the second
+//! since the epoch (proleptic Gregorian calendar, years 0 .. 9999)
+inline void write_second(int64_t second, char * out) {
+	int64_t days = second / 86400;
+	int64_t rest = second % 86400;
+	if (rest < 0) {
+		rest += 86400;
+		days--;
+	}
+	// civil date from days since 1970-01-01 (H. Hinnant)
+	const int64_t z = days + 719468;
+	const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+	const int64_t doe = z - era * 146097;
+	const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const int64_t mp = (5 * doy + 2) / 153;
+	const int day = int(doy - (153 * mp + 2) / 5 + 1);
+	const int month = int(mp < 10 ? mp + 3 : mp - 9);
+	const int year = int(yoe + era * 400 + (month <= 2));
+	write_2_digits(year / 100, out);
+	write_2_digits(year % 100, out + 2);
+	out[4] = '-';
+	write_2_digits(month, out + 5);
+	out[7] = '-';
+	write_2_digits(day, out + 8);
+	out[10] = 'T';
+	write_2_digits(int(rest / 3600), out + 11);
+	out[13] = ':';
+	write_2_digits(int(rest / 60 % 60), out + 14);
+	out[16] = ':';
+	write_2_digits(int(rest % 60), out + 17);
+}
+
+//! the last second formatted by a thread
+struct cache {
+	int64_t second;
+	char text[19];
+};
+
+//! the cache of the calling thread
+inline cache & local() {
+	static thread_local cache c = { INT64_MIN, { 0 } };
+	return c;
+}
+
+} // namespace timestamp
+
+//! Appends t as ISO-8601 UTC timestamp with p digits of fraction,
+//! e.g. 2024-05-06T07:08:09.123Z, with the truncation rules of
+//! append(const char *, int)
+inline void append_timestamp(fixed_string<0> & fs, std::chrono::system_clock::time_point t,
+		timestamp::precision p = timestamp::milliseconds) {
+	const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+	int64_t second = ns / 1000000000;
+	int64_t fraction = ns % 1000000000;
+	if (fraction < 0) {
+		fraction += 1000000000;
+		second--;
+	}
+	timestamp::cache & c = timestamp::local();
+	if (c.second != second) {
+		timestamp::write_second(second, c.text);
+		c.second = second;
+	}
+	char buff[32];
+	std::memcpy(buff, c.text, 19);
+	int len = 19;
+	if (p != timestamp::seconds) {
+		// the p leading digits of the nine digit fraction
+		char digits[9];
+		digits[0] = char('0' + fraction / 100000000);
+		timestamp::write_8_digits(uint32_t(fraction % 100000000), digits + 1);
+		buff[len++] = '.';
+		std::memcpy(buff + len, digits, p);
+		len += p;
+	}
+	buff[len++] = 'Z';
+	fs.append(buff, len);
+}
+
+} // namespace fixed_string
+#endif /* FIXED_STRING_TIME_HPP_ */
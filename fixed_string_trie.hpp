@@ -0,0 +1,369 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fixed_string_trie.hpp
+ *
+ *  Maps fixed_string keys to values in a radix tree (a trie whose
+ *  edges carry whole runs of characters), so it can answer what a hash
+ *  map cannot: the longest stored key that is a prefix of a string,
+ *  and all keys under a prefix, in order. Nodes and edge labels come
+ *  from statically sized pools.
+ */
+
+#ifndef FIXED_STRING_TRIE_HPP_
+#define FIXED_STRING_TRIE_HPP_
+
+#include <cstring>
+
+#include "fixed_string.hpp"
+
+namespace fixed_string {
+
+//! @brief radix tree of keys up to N characters, without heap allocations
+//! @details
+//! Usage:
+//! \code
+//! static fixed_string_trie<64, handler, 1024> routes;
+//! routes.insert("eu/", eu_default);
+//! routes.insert("eu/host7/", host7_handler);
+//! const handler * h = routes.longest_prefix("eu/host7/cpu");   // host7_handler
+//! routes.for_each_prefix("eu/", [](const fixed_string<0> & key, const handler & h) { });
+//! \endcode
+//! Every key takes at most two nodes (its own and one where an edge is
+//! split), so (MaxNodes - 1) / 2 keys always fit, and usually almost
+//! MaxNodes do. Edge labels are stored once in
+//! a character pool of MaxNodes * N bytes; splitting an edge only
+//! divides its label. The children of a node are kept in a list sorted
+//! by their first character, so walking the tree visits the keys in
+//! the order of std::map<std::string, V>.
+//! V must be default constructible and copy assignable.
+template<int N, typename V, int MaxNodes>
+class fixed_string_trie {
+public:
+	static_assert(N > 0, "keys must be able to hold a character");
+	static_assert(MaxNodes > 0, "the trie needs at least one node");
+
+	fixed_string_trie() {
+		clear();
+	}
+
+	//! Removes all keys
+	void clear() {
+		nodes = 1;
+		chars = 0;
+		keys = 0;
+		pool[0].label = 0;
+		pool[0].length = 0;
+		pool[0].child = -1;
+		pool[0].sibling = -1;
+		pool[0].has_value = false;
+	}
+
+	//! Stores value under the key [s, s + len), replacing the value
+	//! of an existing key. Returns false if the key is longer than N
+	//! or the pools are full; the trie is then unchanged.
+	bool insert(const char * s, int len, const V & value) {
+		if (len < 0 || len > N)
+			return false;
+		int n = 0;
+		int i = 0;
+		for (;;) {
+			if (i == len) {
+				set_value(n, value);
+				return true;
+			}
+			int prev = -1;
+			const int c = child(n, s[i], prev);
+			if (c < 0) {
+				// no edge starts with s[i]: hang a leaf under n
+				if (nodes == MaxNodes || chars + len - i > MaxNodes * N)
+					return false;
+				const int leaf = new_node(s + i, len - i);
+				link(n, prev, leaf);
+				set_value(leaf, value);
+				return true;
+			}
+			const int m = common(c, s + i, len - i);
+			if (m == pool[c].length) {
+				n = c;
+				i += m;
+				continue;
+			}
+			// the key leaves the edge to c after m characters:
+			// split the edge with a node at that point
+			const bool leaf_needed = i + m < len;
+			if (nodes + 1 + leaf_needed > MaxNodes
+					|| (leaf_needed && chars + len - i - m > MaxNodes * N))
+				return false;
+			const int mid = nodes++;
+			pool[mid].label = pool[c].label;
+			pool[mid].length = m;
+			pool[mid].has_value = false;
+			pool[mid].sibling = pool[c].sibling;
+			pool[mid].child = c;
+			if (prev < 0)
+				pool[n].child = mid;
+			else
+				pool[prev].sibling = mid;
+			pool[c].label += m;
+			pool[c].length -= m;
+			pool[c].sibling = -1;
+			if (!leaf_needed) {
+				set_value(mid, value);
+				return true;
+			}
+			int p = -1;
+			child(mid, s[i + m], p);
+			const int leaf = new_node(s + i + m, len - i - m);
+			link(mid, p, leaf);
+			set_value(leaf, value);
+			return true;
+		}
+	}
+
+	bool insert(const char * s, const V & value) {
+		return insert(s, std::strlen(s), value);
+	}
+
+	bool insert(const fixed_string<0> & key, const V & value) {
+		return insert(key.begin(), key.get_used_length(), value);
+	}
+
+	//! Returns the value stored under [s, s + len), or 0
+	const V * find(const char * s, int len) const {
+		const int n = walk(s, len);
+		return n >= 0 && pool[n].has_value ? &pool[n].value : 0;
+	}
+
+	const V * find(const char * s) const {
+		return find(s, std::strlen(s));
+	}
+
+	const V * find(const fixed_string<0> & key) const {
+		return find(key.begin(), key.get_used_length());
+	}
+
+	//! Returns the value of the longest key that is a prefix of
+	//! [s, s + len), or 0 if no key is. If matched is not 0, it is
+	//! set to the length of that key.
+	const V * longest_prefix(const char * s, int len, int * matched = 0) const {
+		const V * best = pool[0].has_value ? &pool[0].value : 0;
+		int best_length = 0;
+		int n = 0;
+		int i = 0;
+		while (i < len) {
+			int prev;
+			const int c = child(n, s[i], prev);
+			if (c < 0 || pool[c].length > len - i
+					|| std::memcmp(label(c), s + i, pool[c].length) != 0)
+				break;
+			n = c;
+			i += pool[c].length;
+			if (pool[n].has_value) {
+				best = &pool[n].value;
+				best_length = i;
+			}
+		}
+		if (matched)
+			*matched = best ? best_length : 0;
+		return best;
+	}
+
+	const V * longest_prefix(const char * s, int * matched = 0) const {
+		return longest_prefix(s, std::strlen(s), matched);
+	}
+
+	const V * longest_prefix(const fixed_string<0> & fs, int * matched = 0) const {
+		return longest_prefix(fs.begin(), fs.get_used_length(), matched);
+	}
+
+	//! Calls f(key, value) for every key that starts with
+	//! [s, s + len), in ascending order of the keys. key is a
+	//! fixed_string<0> that is only valid during the call.
+	template<typename F>
+	void for_each_prefix(const char * s, int len, F f) const {
+		// find the node whose path first covers the prefix
+		int n = 0;
+		int i = 0;
+		while (i < len) {
+			int prev;
+			const int c = child(n, s[i], prev);
+			if (c < 0)
+				return;
+			const int m = common(c, s + i, len - i);
+			if (m < pool[c].length && i + m < len)
+				return;
+			n = c;
+			i += pool[c].length;
+		}
+		if (len > N)
+			return;
+		char path[N];
+		std::memcpy(path, s, len);
+		// the part of n's label behind the prefix
+		std::memcpy(path + len, label(n) + pool[n].length - (i - len), i - len);
+		fixed_string<N> key;
+		visit(n, path, i, key, f);
+	}
+
+	template<typename F>
+	void for_each_prefix(const char * s, F f) const {
+		for_each_prefix(s, std::strlen(s), f);
+	}
+
+	template<typename F>
+	void for_each_prefix(const fixed_string<0> & prefix, F f) const {
+		for_each_prefix(prefix.begin(), prefix.get_used_length(), f);
+	}
+
+	//! Calls f(key, value) for all keys, in ascending order
+	template<typename F>
+	void for_each(F f) const {
+		for_each_prefix("", 0, f);
+	}
+
+	//! Returns the number of keys stored
+	int size() const {
+		return keys;
+	}
+
+	//! Returns the number of nodes in use
+	int get_node_count() const {
+		return nodes;
+	}
+
+private:
+	struct node {
+		//! the characters on the edge into this node are
+		//! chars [label, label + length) of the label pool
+		int label;
+		int length;
+		//! first child, and next child of the parent; -1 if none
+		int child;
+		int sibling;
+		bool has_value;
+		V value;
+	};
+
+	const char * label(int n) const {
+		return labels + pool[n].label;
+	}
+
+	//! Returns the child of n whose label starts with ch, or -1.
+	//! prev is set to the child that is (or would be) before it.
+	int child(int n, char ch, int & prev) const {
+		const unsigned char u = ch;
+		prev = -1;
+		for (int c = pool[n].child; c >= 0; c = pool[c].sibling) {
+			const unsigned char first = labels[pool[c].label];
+			if (first == u)
+				return c;
+			if (first > u)
+				return -1;
+			prev = c;
+		}
+		return -1;
+	}
+
+	//! number of leading characters of [s, s + len) that match
+	//! the label of c
+	int common(int c, const char * s, int len) const {
+		const char * l = label(c);
+		const int max = pool[c].length < len ? pool[c].length : len;
+		int m = 0;
+		while (m < max && l[m] == s[m])
+			m++;
+		return m;
+	}
+
+	//! Returns the node that ends exactly at [s, s + len), or -1
+	int walk(const char * s, int len) const {
+		int n = 0;
+		int i = 0;
+		while (i < len) {
+			int prev;
+			const int c = child(n, s[i], prev);
+			if (c < 0 || pool[c].length > len - i
+					|| std::memcmp(label(c), s + i, pool[c].length) != 0)
+				return -1;
+			n = c;
+			i += pool[c].length;
+		}
+		return n;
+	}
+
+	//! takes a node from the pool, with a copy of [s, s + len) as label
+	int new_node(const char * s, int len) {
+		const int n = nodes++;
+		std::memcpy(labels + chars, s, len);
+		pool[n].label = chars;
+		pool[n].length = len;
+		pool[n].child = -1;
+		pool[n].sibling = -1;
+		pool[n].has_value = false;
+		chars += len;
+		return n;
+	}
+
+	//! inserts c in the children of n, behind prev (-1: first)
+	void link(int n, int prev, int c) {
+		if (prev < 0) {
+			pool[c].sibling = pool[n].child;
+			pool[n].child = c;
+		} else {
+			pool[c].sibling = pool[prev].sibling;
+			pool[prev].sibling = c;
+		}
+	}
+
+	void set_value(int n, const V & value) {
+		if (!pool[n].has_value)
+			keys++;
+		pool[n].has_value = true;
+		pool[n].value = value;
+	}
+
+	//! calls f for n and everything below it; path holds the
+	//! depth characters on the way to n. The key is copied out of
+	//! path per call, as a label may end inside a UTF-8 sequence
+	//! which fixed_string would not keep.
+	template<typename F>
+	void visit(int n, char * path, int depth, fixed_string<N> & key, F & f) const {
+		if (pool[n].has_value) {
+			key.assign(path, depth);
+			f(static_cast<const fixed_string<0> &>(key), pool[n].value);
+		}
+		for (int c = pool[n].child; c >= 0; c = pool[c].sibling) {
+			std::memcpy(path + depth, label(c), pool[c].length);
+			visit(c, path, depth + pool[c].length, key, f);
+		}
+	}
+
+	node pool[MaxNodes];
+	char labels[MaxNodes * N];
+	int nodes;
+	int chars;
+	int keys;
+};
+
+} // namespace fixed_string
+#endif /* FIXED_STRING_TRIE_HPP_ */
@@ -21,12 +21,29 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <chrono>
 
 #include "fixed_string.hpp"
+#include "fixed_string_arena.hpp"
+#include "fixed_string_match.hpp"
+#include "fixed_string_aho_corasick.hpp"
+#include "fixed_string_switch.hpp"
+#include "fixed_string_batch.hpp"
+#include "fixed_string_serial.hpp"
+#include "fixed_string_hashed.hpp"
+#include "fixed_string_hybrid.hpp"
+#include "fixed_string_trie.hpp"
+#include "fixed_string_sorted_set.hpp"
+#include "fixed_string_bloom.hpp"
+#include "fixed_string_time.hpp"
+#include "fixed_string_log.hpp"
 #include "defines.hpp"
 #include <iostream>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unistd.h>
 
 TEST(fixed_string, Constructor_char) {
 	// ctor char
@@ -573,6 +590,15 @@ TEST(fixed_string, comparisons) {
 
 	EXPECT_TRUE(fs_a >= 'A');
 	EXPECT_FALSE(fs_a >= "ab");
+
+	// bytes above 0x7F compare as unsigned, whichever overload runs
+	const fixed_string::fixed_string<8> high("\xc3\xa9");
+	EXPECT_TRUE(fs_a < "\xc3\xa9");
+	EXPECT_TRUE(fs_a < '\xc3');
+	EXPECT_TRUE(fs_a < high);
+	EXPECT_TRUE(fs_a < std::string("\xc3\xa9"));
+	EXPECT_TRUE(high > "a");
+	EXPECT_TRUE(high > 'a');
 }
 
 
@@ -797,6 +823,1208 @@ TEST(fixed_string, swap) {
 
 }
 
+TEST(fixed_string, utf8) {
+	// "h\u00e9llo \u20ac" : 2-byte and 3-byte sequences
+	fixed_string::fixed_string<20> fs("h\xC3\xA9llo \xE2\x82\xAC");
+	EXPECT_TRUE(fs.is_valid_utf8());
+	EXPECT_EQ(10,									fs.get_used_length());
+	EXPECT_EQ(7,									fs.codepoint_count());
+
+	char32_t expected[] = { 'h', 0xE9, 'l', 'l', 'o', ' ', 0x20AC };
+	int i = 0;
+	for (char32_t cp : fs.codepoints())
+		EXPECT_EQ(expected[i++], cp);
+	EXPECT_EQ(7, i);
+
+	// invalid: lone continuation, overlong, surrogate, truncated
+	fixed_string::fixed_string<40> invalid("abc\x80");
+	EXPECT_FALSE(invalid.is_valid_utf8());
+	invalid = "\xC0\xAF";
+	EXPECT_FALSE(invalid.is_valid_utf8());
+	invalid = "\xED\xA0\x80";
+	EXPECT_FALSE(invalid.is_valid_utf8());
+	invalid = "0123456789abcdef\xE2\x82";
+	EXPECT_FALSE(invalid.is_valid_utf8());
+	invalid = "0123456789abcdef\xF0\x9F\x98\x80";
+	EXPECT_TRUE(invalid.is_valid_utf8());
+	EXPECT_EQ(17,									invalid.codepoint_count());
+}
+
+#if defined(UTF8SAFETRUNCATION)
+TEST(fixed_string, utf8_truncation) {
+	// the euro sign does not fit: back off to "ab"
+	fixed_string::fixed_string<4> fs("ab\xE2\x82\xAC");
+	EXPECT_STREQ("ab",								fs.c_str());
+	EXPECT_EQ(2,									fs.get_used_length());
+	EXPECT_TRUE(fs.is_valid_utf8());
+
+	fs = "a\xC3\xA9\xC3\xA9";
+	EXPECT_STREQ("a\xC3\xA9",						fs.c_str());
+
+	fs = "abc";
+	fs += "\xC3\xA9";
+	EXPECT_STREQ("abc",								fs.c_str());
+
+	fixed_string::fixed_string<2> fs_small("\xC3\xA9");
+	fixed_string::fixed_string<1> fs_smaller(fs_small);
+	EXPECT_STREQ("",								fs_smaller.c_str());
+	EXPECT_EQ(0,									fs_smaller.get_used_length());
+}
+#endif
+TEST(fixed_string, arena) {
+	static char block[128];
+	fixed_string::fixed_string_arena arena(block, sizeof(block));
+	EXPECT_EQ(0,									arena.get_used_bytes());
+
+	fixed_string::fixed_string<0> * fs1 = arena.create(5, "helloworld");
+	fixed_string::fixed_string<0> * fs2 = arena.create(10);
+	ASSERT_TRUE(fs1 != 0);
+	ASSERT_TRUE(fs2 != 0);
+	EXPECT_STREQ("hello",							fs1->c_str());
+	EXPECT_EQ(6,									fs1->get_allocated_length());
+	EXPECT_EQ(5,									fs1->get_used_length());
+
+	*fs2 = "helloworld!";
+	EXPECT_STREQ("helloworld",						fs2->c_str());
+	*fs2 = *fs1;
+	*fs2 += " you";
+	EXPECT_STREQ("hello you",						fs2->c_str());
+	// neighbouring strings are left alone
+	EXPECT_STREQ("hello",							fs1->c_str());
+
+	// block exhausted
+	EXPECT_TRUE(arena.create(100) == 0);
+	// sizes that would overflow an int
+	EXPECT_TRUE(arena.create(0x7fffffff) == 0);
+	EXPECT_TRUE(arena.create(0x7fffffff - 8) == 0);
+
+	arena.reset();
+	EXPECT_EQ(0,									arena.get_used_bytes());
+	fixed_string::fixed_string<0> * fs3 = arena.create(64, "reused");
+	ASSERT_TRUE(fs3 != 0);
+	EXPECT_STREQ("reused",							fs3->c_str());
+}
+TEST(fixed_string, insert_erase_replace) {
+	fixed_string::fixed_string<10> fs("hello");
+	fs.insert(0, "> ");
+	EXPECT_STREQ("> hello",							fs.c_str());
+	fs.insert(7, '!');
+	EXPECT_STREQ("> hello!",						fs.c_str());
+	fs.erase(0, 2);
+	EXPECT_STREQ("hello!",							fs.c_str());
+	EXPECT_EQ(6,									fs.get_used_length());
+	fs.erase(4, 100);
+	EXPECT_STREQ("hell",							fs.c_str());
+
+	fs = "hello";
+	fs.replace(1, 3, "EY");
+	EXPECT_STREQ("hEYo",							fs.c_str());
+	fs.replace(0, 0, "1234567");
+	EXPECT_STREQ("1234567hEY",						fs.c_str());
+
+	// insertion that does not fit discards the tail
+	fs = "abcdefgh";
+	fs.insert(2, "XYZ");
+	EXPECT_STREQ("abXYZcdefg",						fs.c_str());
+	EXPECT_EQ(10,									fs.get_used_length());
+	fs = "abcdefgh";
+	fs.insert(4, "0123456789");
+	EXPECT_STREQ("abcd012345",						fs.c_str());
+
+	fixed_string::fixed_string_with_guard sc('a');
+	sc += "bcdefghijklmno";
+	sc.insert(0, "0123456789");
+	ASSERT_TRUE(sc.check_padding());
+	ASSERT_STREQ("0123456789abcde",					sc.c_str());
+
+	// the string itself as source
+	fs = "abc";
+	fs.insert(1, fs);
+	EXPECT_STREQ("aabcbc",							fs.c_str());
+	fs = "abcd";
+	fs.replace(1, 2, fs);
+	EXPECT_STREQ("aabcdd",							fs.c_str());
+	fs = "abcdef";
+	fs.insert(0, fs);
+	EXPECT_STREQ("abcdefabcd",						fs.c_str());
+	fs = "0123456789";
+	fs.insert(2, fs.c_str() + 5);
+	EXPECT_STREQ("0156789234",						fs.c_str());
+	fs = "a-b";
+	EXPECT_EQ(1,									fs.replace_all("-", fs));
+	EXPECT_STREQ("aa-bb",							fs.c_str());
+	fs = "a-b-";
+	EXPECT_EQ(2,									fs.replace_all("-", fs));
+	EXPECT_STREQ("aa-b-ba-b-",						fs.c_str());
+}
+
+TEST(fixed_string, replace_all_resize) {
+	fixed_string::fixed_string<40> fs("user=bob;pass=secret;pass=x");
+	EXPECT_EQ(2,									fs.replace_all("pass=", "p="));
+	EXPECT_STREQ("user=bob;p=secret;p=x",			fs.c_str());
+	EXPECT_EQ(2,									fs.replace_all(";", " ; "));
+	EXPECT_STREQ("user=bob ; p=secret ; p=x",		fs.c_str());
+	EXPECT_EQ(0,									fs.replace_all("nope", "x"));
+	EXPECT_EQ(1,									fs.replace_all("aaa", "b") + fs.replace_all("bob", "alice"));
+	EXPECT_STREQ("user=alice ; p=secret ; p=x",		fs.c_str());
+
+	fixed_string::fixed_string<6> small("aaaa");
+	EXPECT_EQ(2,									small.replace_all("aa", "a"));
+	EXPECT_STREQ("aa",								small.c_str());
+	EXPECT_EQ(2,									small.replace_all('a', "xxx"));
+	EXPECT_STREQ("xxxxxx",							small.c_str());
+
+	small.truncate(2);
+	EXPECT_STREQ("xx",								small.c_str());
+	small.resize(4, '-');
+	EXPECT_STREQ("xx--",							small.c_str());
+	small.resize(10, '+');
+	EXPECT_STREQ("xx--++",							small.c_str());
+	EXPECT_EQ(6,									small.get_used_length());
+	small.resize(1);
+	EXPECT_STREQ("x",								small.c_str());
+}
+constexpr char glob_latency[] = "metrics.*.latency";
+constexpr char glob_user[] = "user?_*";
+constexpr char glob_exact[] = "exact";
+constexpr char glob_middle[] = "a*b?c*d";
+
+TEST(fixed_string, glob_match) {
+	fixed_string::fixed_string<40> fs("metrics.host1.latency");
+	EXPECT_TRUE(fixed_string::match<glob_latency>(fs));
+	EXPECT_TRUE(fixed_string::match("metrics.*.latency", fs));
+	EXPECT_FALSE(fixed_string::match<glob_user>(fs));
+	fs = "metrics..latency";
+	EXPECT_TRUE(fixed_string::match<glob_latency>(fs));
+	fs = "metrics.latency";
+	EXPECT_FALSE(fixed_string::match<glob_latency>(fs));
+	EXPECT_FALSE(fixed_string::match("metrics.*.latency", fs));
+
+	fs = "user1_";
+	EXPECT_TRUE(fixed_string::match<glob_user>(fs));
+	fs = "user12_x";
+	EXPECT_FALSE(fixed_string::match<glob_user>(fs));
+	EXPECT_FALSE(fixed_string::match("user?_*", fs));
+
+	fs = "exact";
+	EXPECT_TRUE(fixed_string::match<glob_exact>(fs));
+	fs = "exactly";
+	EXPECT_FALSE(fixed_string::match<glob_exact>(fs));
+
+	fs = "aXbYcZbQcd";
+	EXPECT_TRUE(fixed_string::match<glob_middle>(fs));
+	EXPECT_TRUE(fixed_string::match("a*b?c*d", fs));
+	fs = "abcd";
+	EXPECT_FALSE(fixed_string::match<glob_middle>(fs));
+	EXPECT_TRUE(fixed_string::match("*", fs));
+	EXPECT_TRUE(fixed_string::match("a**d", fs));
+}
+TEST(fixed_string, aho_corasick) {
+	static fixed_string::aho_corasick<64, 8> ac;
+	EXPECT_EQ(0,									ac.add("he"));
+	EXPECT_EQ(1,									ac.add("she"));
+	EXPECT_EQ(2,									ac.add(fixed_string::fixed_string<5>("his")));
+	EXPECT_EQ(3,									ac.add("hers"));
+	EXPECT_EQ(1,									ac.add("she"));
+	EXPECT_EQ(-1,									ac.add(""));
+	EXPECT_EQ(4,									ac.get_pattern_count());
+	fixed_string::fixed_string<20> fs("ushers");
+	// nothing is found before build()
+	EXPECT_EQ(-1,									ac.find_any(fs));
+	EXPECT_EQ(-1,									ac.count(fs));
+	ac.build();
+	EXPECT_EQ(-1,									ac.add("late"));
+
+	EXPECT_EQ(1,									ac.find_any(fs));
+	EXPECT_EQ(3,									ac.count(fs));
+	// a second build() leaves the automaton as it is
+	ac.build();
+	EXPECT_EQ(1,									ac.find_any(fs));
+	EXPECT_EQ(3,									ac.count(fs));
+
+	int found[3][2];
+	int n = 0;
+	ac.find_all(fs, [&](int pattern, int pos) {
+		found[n][0] = pattern;
+		found[n][1] = pos;
+		n++;
+	});
+	ASSERT_EQ(3, n);
+	// "she" and "he" end at the same position, longest first
+	EXPECT_EQ(1, found[0][0]); EXPECT_EQ(1, found[0][1]);
+	EXPECT_EQ(0, found[1][0]); EXPECT_EQ(2, found[1][1]);
+	EXPECT_EQ(3, found[2][0]); EXPECT_EQ(2, found[2][1]);
+
+	fs = "nothing to see";
+	EXPECT_EQ(-1,									ac.find_any(fs));
+	EXPECT_EQ(0,									ac.count(fs));
+
+	// automaton full
+	fixed_string::aho_corasick<4, 8> tiny;
+	EXPECT_EQ(0,									tiny.add("abc"));
+	EXPECT_EQ(-1,									tiny.add("x"));
+}
+constexpr char cmd_get[] = "GET";
+constexpr char cmd_put[] = "PUT";
+constexpr char cmd_delete[] = "DELETE";
+constexpr char cmd_head[] = "HEAD";
+
+TEST(fixed_string, string_switch) {
+	typedef fixed_string::string_switch<cmd_get, cmd_put, cmd_delete, cmd_head> commands;
+	fixed_string::fixed_string<10> fs("DELETE");
+	int result = -2;
+	switch (commands::index(fs)) {
+	case commands::index_of<cmd_get>():
+		result = 0;
+		break;
+	case commands::index_of<cmd_delete>():
+		result = 2;
+		break;
+	case -1:
+		result = -1;
+		break;
+	}
+	EXPECT_EQ(2,									result);
+	fs = "HEAD";
+	EXPECT_EQ(3,									commands::index(fs));
+	fs = "HEA";
+	EXPECT_EQ(-1,									commands::index(fs));
+	fs = "HEADS";
+	EXPECT_EQ(-1,									commands::index(fs));
+
+	static const char * keywords[] = { "alpha", "beta", "gamma", "delta", "epsilon",
+			"zeta", "eta", "theta", "iota", "kappa", "lambda", "mu", "nu" };
+	static const fixed_string::string_table<13> table(keywords);
+	for (int i = 0; i < 13; i++) {
+		fs = keywords[i];
+		EXPECT_EQ(i,								table.index(fs));
+	}
+	EXPECT_EQ(-1,									table.index("omega"));
+	EXPECT_EQ(-1,									table.index(""));
+
+	// duplicates cannot be hashed perfectly, but still work
+	static const char * duplicates[] = { "same", "other", "same" };
+	static const fixed_string::string_table<3> dup_table(duplicates);
+	EXPECT_EQ(0,									dup_table.index("same"));
+	EXPECT_EQ(1,									dup_table.index("other"));
+}
+TEST(fixed_string, batch) {
+	static fixed_string::fixed_string<16> strings[10000];
+	char buff[16];
+	for (int i = 0; i < 10000; i++) {
+		snprintf(buff, sizeof(buff), "KEY%d", i % 100);
+		strings[i] = buff;
+	}
+	static uint64_t hashes[10000];
+	static int indices[10000];
+
+	for (int threads = 1; threads <= 4; threads += 3) {
+		fixed_string::batch_pool pool(threads);
+		EXPECT_EQ(threads,							pool.get_thread_count());
+
+		fixed_string::hash_all(&pool, strings, 10000, hashes);
+		EXPECT_EQ(strings[5].hash(),				hashes[5]);
+		EXPECT_EQ(hashes[5],						hashes[105]);
+		EXPECT_NE(hashes[5],						hashes[6]);
+
+		const fixed_string::fixed_string<16> key("KEY42");
+		const int n = fixed_string::find_equal_all(&pool, strings, 10000, key, indices);
+		ASSERT_EQ(100,								n);
+		for (int i = 0; i < n; i++)
+			EXPECT_EQ(42 + 100 * i,					indices[i]);
+
+		EXPECT_EQ(1000,								fixed_string::count_if(&pool, strings, 10000,
+				[](const fixed_string::fixed_string<16> & fs) { return fs.get_used_length() == 4; }));
+	}
+
+	fixed_string::batch_pool pool(3);
+	fixed_string::transform_all(&pool, strings, 10000, [](fixed_string::fixed_string<16> & fs) {
+		fs.replace(0, 3, "k");
+	});
+	EXPECT_STREQ("k42",								strings[9942].c_str());
+	EXPECT_EQ(0,									fixed_string::find_equal_all(strings, 10000,
+			fixed_string::fixed_string<16>("KEY42"), indices));
+	EXPECT_EQ(100,									fixed_string::find_equal_all(strings, 10000,
+			fixed_string::fixed_string<16>("k42"), indices));
+}
+
+TEST(fixed_string, serial) {
+	char buff[300];
+	fixed_string::fixed_string<200> fs("hello");
+	EXPECT_EQ(6,									fixed_string::serial::encoded_size(fs));
+	EXPECT_EQ(6,									fixed_string::serial::encode(fs, buff, sizeof(buff)));
+	EXPECT_EQ(5,									buff[0]);
+	EXPECT_EQ(-1,									fixed_string::serial::encode(fs, buff, 5));
+
+	fixed_string::serial::view v;
+	EXPECT_EQ(6,									fixed_string::serial::decode(buff, 6, v));
+	EXPECT_EQ(buff + 1,								v.data);
+	EXPECT_EQ(5,									v.length);
+	EXPECT_EQ(-1,									fixed_string::serial::decode(buff, 5, v));
+
+	// two byte varint, decoded into a shorter string
+	fs = "";
+	fs.resize(130, 'x');
+	EXPECT_EQ(132,									fixed_string::serial::encode(fs, buff, sizeof(buff)));
+	fixed_string::fixed_string<10> small;
+	EXPECT_EQ(132,									fixed_string::serial::decode(buff, sizeof(buff), small));
+	EXPECT_STREQ("xxxxxxxxxx",						small.c_str());
+
+	// a varint with bits beyond 32 is malformed, not a shorter length
+	const char over[6] = { '\x81', '\x80', '\x80', '\x80', '\x10', 'a' };
+	EXPECT_EQ(-1,									fixed_string::serial::decode(over, 6, v));
+	unsigned int value;
+	const char top[5] = { '\xff', '\xff', '\xff', '\xff', '\x0f' };
+	EXPECT_EQ(5,									fixed_string::serial::read_varint(top, 5, value));
+	EXPECT_EQ(0xFFFFFFFFu,							value);
+
+	// batches
+	fixed_string::fixed_string<8> in[3] = { "a", "", "12345678" };
+	fixed_string::fixed_string<8> out[3];
+	const int n = fixed_string::serial::encode_all(in, 3, buff, sizeof(buff));
+	EXPECT_EQ(12,									n);
+	EXPECT_EQ(n,									fixed_string::serial::decode_all(buff, n, out, 3));
+	EXPECT_STREQ("a",								out[0].c_str());
+	EXPECT_STREQ("",								out[1].c_str());
+	EXPECT_STREQ("12345678",						out[2].c_str());
+	EXPECT_EQ(-1,									fixed_string::serial::decode_all(buff, n - 1, out, 3));
+
+	EXPECT_EQ(24,									fixed_string::serial::encode_all_padded(in, 3, buff, sizeof(buff), 8));
+	EXPECT_EQ(0,									buff[1]);
+	out[0] = out[1] = out[2] = "zz";
+	EXPECT_EQ(24,									fixed_string::serial::decode_all_padded(buff, 24, out, 3, 8));
+	EXPECT_STREQ("a",								out[0].c_str());
+	EXPECT_STREQ("",								out[1].c_str());
+	EXPECT_STREQ("12345678",						out[2].c_str());
+	EXPECT_EQ(8,									out[2].get_used_length());
+	// no records of zero or negative width
+	EXPECT_EQ(-1,									fixed_string::serial::encode_all_padded(in, 3, buff, sizeof(buff), 0));
+	EXPECT_EQ(-1,									fixed_string::serial::decode_all_padded(buff, 24, out, 3, 0));
+	EXPECT_EQ(-1,									fixed_string::serial::decode_all_padded(buff, 24, out, 3, -8));
+	EXPECT_EQ(-1,									fixed_string::serial::encode_padded(in[0], buff, -1));
+}
+
+TEST(fixed_string, terminator) {
+	// leaves "abcdef" behind the terminator of "ab"
+	fixed_string::fixed_string<10> fs("abcdef");
+	fs.truncate(2);
+	fs += 'x';
+	fs += 'y';
+	EXPECT_EQ(4,									fs.get_used_length());
+	EXPECT_TRUE(fs == "abxy");
+	EXPECT_FALSE(fs == "abxye");
+	EXPECT_FALSE(fs > "abxy");
+	EXPECT_TRUE(fs > "abx");
+	const fixed_string::fixed_string<0> & view = fs;
+	EXPECT_EQ('y',									view[3]);
+	EXPECT_EQ('\0',									view[4]);
+	fixed_string::fixed_string<8> d("abc");
+	d = "";
+	d.append('x');
+	EXPECT_EQ('x',									d[0]);
+	EXPECT_EQ('\0',									d[1]);
+	EXPECT_STREQ("abxy",							fs.c_str());
+
+	const fixed_string::fixed_string<10> copy(fs);
+	EXPECT_STREQ("abxy",							copy.c_str());
+	fixed_string::fixed_string<10> other("12345678");
+	fs += 'z';
+	fs.swap(other);
+	EXPECT_STREQ("12345678",						fs.c_str());
+	EXPECT_STREQ("abxyz",							other.c_str());
+}
+
+TEST(fixed_string, hashed) {
+	fixed_string::hashed_fixed_string<16> a("metrics.");
+	a += "host1";
+	a += '7';
+	const fixed_string::hashed_fixed_string<32> b("metrics.host17");
+	EXPECT_STREQ("metrics.host17",					a.c_str());
+	EXPECT_EQ(b.hash(),								a.hash());
+	EXPECT_TRUE(a == b);
+	EXPECT_FALSE(a != b);
+	EXPECT_TRUE(a == "metrics.host17");
+	EXPECT_TRUE("metrics.host17" == a);
+	EXPECT_TRUE(a.str() == b);
+	EXPECT_TRUE(a < "n");
+	EXPECT_EQ(std::hash<fixed_string::hashed_fixed_string<16> >()(a), a.hash());
+
+	// edits in place recompute the hash
+	a.edit([](fixed_string::fixed_string<0> & s) { s.replace_all(".", "/"); });
+	EXPECT_STREQ("metrics/host17",					a.c_str());
+	EXPECT_NE(b.hash(),								a.hash());
+	EXPECT_EQ(fixed_string::hashed_fixed_string<16>("metrics/host17").hash(), a.hash());
+	EXPECT_FALSE(a == b);
+
+	// a truncated append only hashes what was stored
+	fixed_string::hashed_fixed_string<4> t("abc");
+	t += "def";
+	EXPECT_STREQ("abcd",							t.c_str());
+	EXPECT_EQ(fixed_string::hashed_fixed_string<4>("abcd").hash(), t.hash());
+	t = "xy";
+	EXPECT_EQ(fixed_string::hashed_fixed_string<8>("xy").hash(), t.hash());
+
+	std::unordered_map<fixed_string::hashed_fixed_string<16>, int> counts;
+	counts["one"]++;
+	counts["one"]++;
+	counts["two"]++;
+	EXPECT_EQ(2,									counts["one"]);
+	EXPECT_EQ(2u,									counts.size());
+
+	std::unordered_map<fixed_string::fixed_string<16>, int> plain;
+	plain["one"] = 1;
+	EXPECT_EQ(1u,									plain.count("one"));
+	EXPECT_EQ(0u,									plain.count("two"));
+
+	// hashed_fixed_strings of other lengths
+	fixed_string::hashed_fixed_string<16> h16("ab");
+	const fixed_string::hashed_fixed_string<32> h32("cd");
+	EXPECT_TRUE(h16 < h32);
+	EXPECT_TRUE(h16 <= h32);
+	EXPECT_FALSE(h16 > h32);
+	EXPECT_FALSE(h16 >= h32);
+	h16 += h32;
+	EXPECT_STREQ("abcd",							h16.c_str());
+	EXPECT_EQ(fixed_string::hashed_fixed_string<8>("abcd").hash(), h16.hash());
+	EXPECT_TRUE(h16 < h32);
+	h16 = h32;
+	EXPECT_TRUE(h16 == h32);
+	EXPECT_TRUE(h16 <= h32);
+	EXPECT_TRUE(h16 >= h32);
+	EXPECT_EQ(h32.hash(),							h16.hash());
+	fixed_string::hashed_fixed_string<4> h4;
+	h4 = fixed_string::hashed_fixed_string<32>("too long");
+	EXPECT_STREQ("too ",							h4.c_str());
+	EXPECT_EQ(fixed_string::hashed_fixed_string<8>("too ").hash(), h4.hash());
+}
+
+TEST(fixed_string, trie) {
+	static fixed_string::fixed_string_trie<32, int, 16> routes;
+	EXPECT_TRUE(routes.insert("eu/host1/cpu", 1));
+	EXPECT_TRUE(routes.insert("eu/host1/mem", 2));
+	EXPECT_TRUE(routes.insert("eu/host2/cpu", 3));
+	EXPECT_TRUE(routes.insert("eu/", 4));
+	EXPECT_TRUE(routes.insert("us/host9", 5));
+	EXPECT_TRUE(routes.insert("eu/host1/", 6));
+	EXPECT_TRUE(routes.insert(fixed_string::fixed_string<16>("eu/host1/cpu"), 7));
+	EXPECT_EQ(6,									routes.size());
+	EXPECT_FALSE(routes.insert("a key that is far longer than 32 chars", 0));
+
+	EXPECT_EQ(7,									*routes.find("eu/host1/cpu"));
+	EXPECT_EQ(4,									*routes.find("eu/"));
+	EXPECT_EQ(0,									routes.find("eu/host1"));
+	EXPECT_EQ(0,									routes.find("eu/host1/cpux"));
+	EXPECT_EQ(0,									routes.find("asia"));
+
+	int matched;
+	EXPECT_EQ(6,									*routes.longest_prefix("eu/host1/disk", &matched));
+	EXPECT_EQ(9,									matched);
+	EXPECT_EQ(4,									*routes.longest_prefix("eu/host3/cpu"));
+	EXPECT_EQ(7,									*routes.longest_prefix("eu/host1/cpu/0"));
+	EXPECT_EQ(0,									routes.longest_prefix("us/host", &matched));
+	EXPECT_EQ(0,									matched);
+
+	// in order, like std::map, also when the prefix ends inside an edge
+	fixed_string::fixed_string<128> seen;
+	routes.for_each_prefix("eu/h", [&](const fixed_string::fixed_string<0> & key, int v) {
+		seen += key;
+		seen += '=';
+		seen += char('0' + v);
+		seen += ' ';
+	});
+	EXPECT_STREQ("eu/host1/=6 eu/host1/cpu=7 eu/host1/mem=2 eu/host2/cpu=3 ",	seen.c_str());
+	int n = 0;
+	routes.for_each([&](const fixed_string::fixed_string<0> &, int) { n++; });
+	EXPECT_EQ(6,									n);
+	routes.for_each_prefix("eu/x", [&](const fixed_string::fixed_string<0> &, int) { n++; });
+	EXPECT_EQ(6,									n);
+
+	// the pools are static: a full trie refuses, and stays intact
+	fixed_string::fixed_string_trie<4, int, 4> tiny;
+	EXPECT_TRUE(tiny.insert("ab", 1));
+	EXPECT_TRUE(tiny.insert("ac", 2));
+	EXPECT_FALSE(tiny.insert("b", 3));
+	EXPECT_EQ(2,									tiny.size());
+	EXPECT_EQ(1,									*tiny.find("ab"));
+	routes.clear();
+	EXPECT_EQ(0,									routes.size());
+	EXPECT_EQ(0,									routes.find("eu/"));
+}
+
+TEST(fixed_string, sorted_set) {
+	static fixed_string::sorted_fixed_string_set<16, 16> set;
+	// shared 8 character prefixes make the search break ties
+	fixed_string::fixed_string<24> in[10] = { "metrics.mem", "metrics.cpu", "apple", "metrics.cpu",
+			"metrics.", "zebra", "", "metrics", "metrics.disk.far.too.long", "\xc3\xa9t\xc3\xa9" };
+	EXPECT_EQ(9,									set.build(in, 10));
+	EXPECT_EQ(9,									set.size());
+	const char * sorted[9] = { "", "apple", "metrics", "metrics.", "metrics.cpu", "metrics.disk.far",
+			"metrics.mem", "zebra", "\xc3\xa9t\xc3\xa9" };
+	for (int i = 0; i < 9; i++)
+		EXPECT_STREQ(sorted[i],						set[i].c_str());
+
+	EXPECT_TRUE(set.contains("metrics.cpu"));
+	EXPECT_TRUE(set.contains(""));
+	EXPECT_TRUE(set.contains(fixed_string::fixed_string<8>("zebra")));
+	EXPECT_FALSE(set.contains("metrics.cp"));
+	EXPECT_FALSE(set.contains("metrics.disk"));
+	EXPECT_EQ(4,									set.lower_bound("metrics.b"));
+	EXPECT_EQ(4,									set.lower_bound("metrics.cpu"));
+	EXPECT_EQ(5,									set.upper_bound("metrics.cpu"));
+	EXPECT_EQ(0,									set.lower_bound(""));
+	EXPECT_EQ(1,									set.upper_bound(""));
+	EXPECT_EQ(9,									set.lower_bound("\xff"));
+
+	std::pair<int, int> r = set.range("metrics.", "metrics/");
+	EXPECT_EQ(3,									r.first);
+	EXPECT_EQ(7,									r.second);
+	r = set.range("z", "a");
+	EXPECT_EQ(r.first,								r.second);
+
+	// every lower_bound agrees with a linear search
+	for (int i = 0; i < 10; i++) {
+		int expected = 0;
+		while (expected < set.size() && set[expected] < in[i])
+			expected++;
+		EXPECT_EQ(expected,							set.lower_bound(in[i]));
+	}
+
+	EXPECT_EQ(-1,									set.build(in, 17));
+	EXPECT_EQ(0,									set.size());
+
+	// the order is that of the cut elements, whatever the cut drops
+	static fixed_string::sorted_fixed_string_set<4, 4> cut;
+	fixed_string::fixed_string<8> wide[3] = { "abc\x01", "abc\xc3\xa9", "abcd" };
+	EXPECT_EQ(3,									cut.build(wide, 3));
+	EXPECT_TRUE(cut[0] < cut[1]);
+	EXPECT_TRUE(cut[1] < cut[2]);
+	for (int i = 0; i < 3; i++)
+		EXPECT_TRUE(cut.contains(fixed_string::fixed_string<4>(wide[i])));
+}
+
+//! inserts keys 0 .. 999 and returns the number of false positives
+//! among 10000 keys that were not inserted
+template<typename Filter>
+static int bloom_false_positives(Filter & filter) {
+	static fixed_string::fixed_string<16> keys[1000];
+	char buff[16];
+	for (int i = 0; i < 1000; i++) {
+		std::snprintf(buff, sizeof(buff), "key-%d", i);
+		keys[i] = buff;
+	}
+	filter.insert_all(keys, 1000);
+	static bool out[1000];
+	EXPECT_EQ(1000,									filter.maybe_contains_all(keys, 1000, out));
+	for (int i = 0; i < 1000; i++)
+		EXPECT_TRUE(filter.maybe_contains(keys[i]));
+	int false_positives = 0;
+	for (int i = 1000; i < 11000; i++) {
+		std::snprintf(buff, sizeof(buff), "key-%d", i);
+		false_positives += filter.maybe_contains(buff, std::strlen(buff));
+	}
+	return false_positives;
+}
+
+TEST(fixed_string, bloom) {
+	static fixed_string::bloom_filter<1000, 10> filter;
+	EXPECT_EQ(7,									filter.hashes);
+	EXPECT_FALSE(filter.maybe_contains("key-1", 5));
+	// 0.8 % expected
+	EXPECT_LT(bloom_false_positives(filter),		250);
+	filter.clear();
+	EXPECT_FALSE(filter.maybe_contains(fixed_string::fixed_string<8>("key-1")));
+
+	static fixed_string::blocked_bloom_filter<1000, 10> blocked;
+	EXPECT_LT(bloom_false_positives(blocked),		250);
+	blocked.insert("extra", 5);
+	EXPECT_TRUE(blocked.maybe_contains("extra", 5));
+
+	// fewer bits per key, more false positives
+	static fixed_string::bloom_filter<1000, 4> small;
+	EXPECT_GT(bloom_false_positives(small),			250);
+}
+
+TEST(fixed_string, hex_base64) {
+	unsigned char bytes[40];
+	for (int i = 0; i < 40; i++)
+		bytes[i] = i * 37 + 5;
+	fixed_string::fixed_string<80> hex;
+	// 40 bytes: two 16 byte blocks and a tail
+	EXPECT_TRUE(hex.append_hex(bytes, 40));
+	EXPECT_EQ(80,									hex.get_used_length());
+	EXPECT_STREQ("052a4f7499bee3082d52779cc1e60b30", fixed_string::fixed_string<32>(hex).c_str());
+	unsigned char back[40];
+	EXPECT_EQ(40,									hex.decode_hex_into(back, sizeof(back)));
+	EXPECT_EQ(0,									std::memcmp(bytes, back, 40));
+	EXPECT_EQ(-1,									hex.decode_hex_into(back, 39));
+
+	// upper case decodes too, anything else does not
+	fixed_string::fixed_string<64> upper("DEADbeef00FF");
+	EXPECT_EQ(6,									upper.decode_hex_into(back, sizeof(back)));
+	EXPECT_EQ(0xDE,									back[0]);
+	EXPECT_EQ(0xFF,									back[5]);
+	upper = "00112233445566778899aabbccddeeff0011223344556677889g";
+	EXPECT_EQ(-1,									upper.decode_hex_into(back, sizeof(back)));
+	upper = "00112233445566778899aabbccddeeff0011223344556677889:";
+	EXPECT_EQ(-1,									upper.decode_hex_into(back, sizeof(back)));
+	upper = "abc";
+	EXPECT_EQ(-1,									upper.decode_hex_into(back, sizeof(back)));
+
+	// all or nothing
+	fixed_string::fixed_string<7> small("ab");
+	EXPECT_FALSE(small.append_hex(bytes, 3));
+	EXPECT_STREQ("ab",								small.c_str());
+	EXPECT_EQ('?',									small[-1]);
+
+	// RFC 4648 test vectors
+	const char * plain[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+	const char * encoded[] = { "", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy" };
+	for (int i = 0; i < 7; i++) {
+		fixed_string::fixed_string<16> b64;
+		EXPECT_TRUE(b64.append_base64(plain[i], std::strlen(plain[i])));
+		EXPECT_STREQ(encoded[i],					b64.c_str());
+		char text[8] = { 0 };
+		EXPECT_EQ((int) std::strlen(plain[i]),		b64.decode_base64_into(text, 6));
+		EXPECT_STREQ(plain[i],						text);
+	}
+	fixed_string::fixed_string<16> b64("Zm9vYmFy");
+	EXPECT_EQ(-1,									b64.decode_base64_into(back, 5));
+	b64 = "Zm9v*mFy";
+	EXPECT_EQ(-1,									b64.decode_base64_into(back, sizeof(back)));
+	b64 = "Zm9";
+	EXPECT_EQ(-1,									b64.decode_base64_into(back, sizeof(back)));
+	b64 = "Z=9v";
+	EXPECT_EQ(-1,									b64.decode_base64_into(back, sizeof(back)));
+	b64 = "";
+	EXPECT_TRUE(b64.append_base64(bytes, 12));
+	EXPECT_EQ(12,									b64.decode_base64_into(back, sizeof(back)));
+	EXPECT_EQ(0,									std::memcmp(bytes, back, 12));
+}
+
+TEST(fixed_string, timestamp) {
+	char digits[9] = { 0 };
+	fixed_string::timestamp::write_8_digits(1234567, digits);
+	EXPECT_STREQ("01234567",						digits);
+	fixed_string::timestamp::write_8_digits(99999999, digits);
+	EXPECT_STREQ("99999999",						digits);
+
+	// the same text as strftime + snprintf, across seconds, days and
+	// leap years, also when the cached second is reused
+	typedef std::chrono::system_clock clock;
+	const int64_t starts[] = { 0, 951782399, 1709251199, 4102444799LL, -86401 };
+	for (int64_t start : starts) {
+		for (int64_t step = 0; step < 5; step++) {
+			const int64_t ns = (start + step / 2) * 1000000000LL + step * 123456789;
+			const clock::time_point t(std::chrono::duration_cast<clock::duration>(std::chrono::nanoseconds(ns)));
+			const time_t second = time_t(start + step / 2);
+			struct tm tm;
+			gmtime_r(&second, &tm);
+			char expected[64];
+			int n = strftime(expected, sizeof(expected), "%Y-%m-%dT%H:%M:%S", &tm);
+			const long fraction = long(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					t.time_since_epoch()).count() - int64_t(second) * 1000000000LL);
+			std::snprintf(expected + n, sizeof(expected) - n, ".%03ldZ", fraction / 1000000);
+			fixed_string::fixed_string<32> fs;
+			fixed_string::append_timestamp(fs, t);
+			EXPECT_STREQ(expected,					fs.c_str());
+
+			std::snprintf(expected + n, sizeof(expected) - n, ".%06ldZ", fraction / 1000);
+			fs = "";
+			fixed_string::append_timestamp(fs, t, fixed_string::timestamp::microseconds);
+			EXPECT_STREQ(expected,					fs.c_str());
+		}
+	}
+	fixed_string::fixed_string<32> fs("at ");
+	fixed_string::append_timestamp(fs, clock::time_point(std::chrono::seconds(1)), fixed_string::timestamp::seconds);
+	EXPECT_STREQ("at 1970-01-01T00:00:01Z",			fs.c_str());
+	fs = "";
+	fixed_string::append_timestamp(fs, clock::time_point(std::chrono::duration_cast<clock::duration>(
+			std::chrono::nanoseconds(1000000007))), fixed_string::timestamp::nanoseconds);
+	EXPECT_STREQ("1970-01-01T00:00:01.000000007Z",	fs.c_str());
+}
+
+TEST(fixed_string, logger) {
+	int fds[2];
+	ASSERT_EQ(0,									pipe(fds));
+	char buff[4096];
+	{
+		// without a writer thread the test decides when records are written
+		typedef fixed_string::fixed_string_logger<8, 4> logger;
+		logger log(fds[1], logger::drop, false);
+		EXPECT_TRUE(log.log("one"));
+		EXPECT_TRUE(log.log(fixed_string::fixed_string<4>("two")));
+		EXPECT_TRUE(log.log([](fixed_string::fixed_string<0> & r) { r += "three"; r += '!'; }));
+		EXPECT_TRUE(log.log("a line that is too long"));
+		EXPECT_FALSE(log.log("full"));
+		EXPECT_EQ(1u,								log.get_dropped());
+		EXPECT_EQ(4,								log.drain());
+		EXPECT_EQ(0,								log.drain());
+		EXPECT_EQ(4u,								log.get_written());
+		const int n = read(fds[0], buff, sizeof(buff));
+		EXPECT_EQ("one\ntwo\nthree!\na line \n",	std::string(buff, n));
+
+		// a throwing formatter still releases its slot
+		EXPECT_THROW(log.log([](fixed_string::fixed_string<0> & r) {
+			r += "half";
+			throw std::runtime_error("format");
+		}), std::runtime_error);
+		EXPECT_TRUE(log.log("after"));
+		EXPECT_EQ(2u,								log.get_dropped());
+		log.flush();
+		EXPECT_EQ(5u,								log.get_written());
+		EXPECT_EQ(6,								read(fds[0], buff, sizeof(buff)));
+		EXPECT_EQ("after\n",						std::string(buff, 6));
+
+		// the block policy drains a full ring itself
+		logger blocking(fds[1], logger::block, false);
+		for (int i = 0; i < 10; i++)
+			EXPECT_TRUE(blocking.log("b"));
+		blocking.flush();
+		EXPECT_EQ(0u,								blocking.get_dropped());
+		EXPECT_EQ(20,								read(fds[0], buff, sizeof(buff)));
+	}
+	{
+		// four threads through the writer thread, nothing lost
+		typedef fixed_string::fixed_string_logger<16, 8> logger;
+		logger log(fds[1], logger::block);
+		std::thread threads[4];
+		for (int t = 0; t < 4; t++)
+			threads[t] = std::thread([&log, t]() {
+				for (int i = 0; i < 100; i++)
+					log.log([t](fixed_string::fixed_string<0> & r) { r += char('a' + t); });
+			});
+		int lines[4] = { 0 };
+		int total = 0;
+		while (total < 800) {
+			const int n = read(fds[0], buff, sizeof(buff));
+			ASSERT_GT(n,							0);
+			for (int i = 0; i < n; i += 2)
+				lines[buff[i] - 'a']++;
+			total += n;
+		}
+		for (int t = 0; t < 4; t++) {
+			threads[t].join();
+			EXPECT_EQ(100,							lines[t]);
+		}
+		// the count is updated after writev() returns
+		log.flush();
+		EXPECT_EQ(400u,								log.get_written());
+	}
+	close(fds[0]);
+	close(fds[1]);
+}
+
+TEST(fixed_string, std_string) {
+	// the size() is used, not a strlen() of c_str()
+	const std::string with_zero("ab\0cd", 5);
+	fixed_string::fixed_string<8> fs(with_zero);
+	EXPECT_EQ(5,									fs.get_used_length());
+	EXPECT_EQ(0,									std::memcmp("ab\0cd", fs.begin(), 5));
+	EXPECT_TRUE(fs == with_zero);
+	EXPECT_FALSE(fs == "ab");
+	fs += std::string("ef");
+	EXPECT_EQ(7,									fs.get_used_length());
+	EXPECT_TRUE(fs > with_zero);
+	fs = std::string("xyz");
+	EXPECT_STREQ("xyz",								fs.c_str());
+	EXPECT_TRUE(fs == std::string("xyz"));
+	EXPECT_TRUE(fs != std::string("xy"));
+	EXPECT_TRUE(fs < std::string("xz"));
+	EXPECT_TRUE(fs >= std::string("xyz"));
+	fs = std::string("much too long");
+	EXPECT_STREQ("much too",						fs.c_str());
+	EXPECT_EQ('?',									fs[-1]);
+#if __cplusplus >= 201703L
+	std::string_view view("abc\0def", 7);
+	fixed_string::fixed_string<16> fv(view);
+	EXPECT_EQ(7,									fv.get_used_length());
+	EXPECT_TRUE(fv == view);
+	EXPECT_TRUE(fv.as_view() == view);
+	fv += std::string_view("gh");
+	EXPECT_EQ(9u,									fv.as_view().size());
+	EXPECT_TRUE(fv > view);
+	fv = std::string_view("view");
+	EXPECT_TRUE(fv == std::string_view("view"));
+	EXPECT_TRUE(fv == "view");
+	// passed where a std::string_view is taken, without a copy
+	const std::string_view taken = fv;
+	EXPECT_EQ(fv.begin(),							taken.data());
+	EXPECT_EQ(4u,									taken.size());
+	EXPECT_EQ(std::string("view"),					std::string(taken));
+	// fixed_strings still take fixed_strings, not the view
+	fixed_string::fixed_string<4> copy(fv);
+	EXPECT_TRUE(copy == fv);
+#endif
+}
+
+TEST(fixed_string, literals) {
+	// a literal ends at its first null character, like any char array
+	fixed_string::fixed_string<8> fs("ab\0cd");
+	EXPECT_EQ(2,									fs.get_used_length());
+	EXPECT_TRUE(fs == "ab\0cd");
+	EXPECT_TRUE(fs == "ab");
+	fs = "";
+	EXPECT_EQ(0,									fs.get_used_length());
+	fs = "abc";
+	fs += "def";
+	EXPECT_STREQ("abcdef",							fs.c_str());
+	EXPECT_TRUE(fs > "abcde");
+	EXPECT_TRUE(fs < "abcdefg");
+	EXPECT_TRUE(fs <= "abcdef");
+	EXPECT_TRUE(fs >= "abcdef");
+	EXPECT_TRUE(fs != "abcdeF");
+
+	// longer than N: the truncating path, chosen at compile time
+	fixed_string::fixed_string<4> small("abcdef");
+	EXPECT_STREQ("abcd",							small.c_str());
+	EXPECT_EQ('?',									small[-1]);
+	fixed_string::fixed_string<4> exact("abcd");
+	EXPECT_STREQ("abcd",							exact.c_str());
+
+	// a partly filled const array is measured
+	const char partly[16] = "xyz";
+	fs = partly;
+	EXPECT_EQ(3,									fs.get_used_length());
+	EXPECT_TRUE(fs == partly);
+	// also with bytes left behind its terminator
+	struct record {
+		char name[16];
+	};
+	const record cr = { { 'b', 'o', 'b', '\0', 'X', 'X', 'X', 'X', 'X', 'X', 'X', 'X', 'X', 'X', 'X', 'X' } };
+	fixed_string::fixed_string<32> named(cr.name);
+	EXPECT_EQ(3,									named.get_used_length());
+	EXPECT_TRUE(fixed_string::fixed_string<32>("bob") == cr.name);
+	named = cr.name;
+	EXPECT_EQ(3,									named.get_used_length());
+	named += cr.name;
+	EXPECT_STREQ("bobbob",							named.c_str());
+
+	// a writable buffer is measured too, without reading past it
+	char buff[8];
+	std::memset(buff, 'q', sizeof(buff));
+	std::memcpy(buff, "hi", 3);
+	fixed_string::fixed_string<16> from_buff(buff);
+	EXPECT_STREQ("hi",								from_buff.c_str());
+	EXPECT_TRUE(from_buff == buff);
+	from_buff += buff;
+	EXPECT_STREQ("hihi",							from_buff.c_str());
+	std::memset(buff, 'q', sizeof(buff));
+	from_buff = buff;
+	EXPECT_EQ(7,									from_buff.get_used_length());
+	fixed_string::fixed_string<7> fits(buff);
+	EXPECT_EQ(7,									fits.get_used_length());
+
+	// and stays writable through the wrappers
+	std::memcpy(buff, "hi", 3);
+	fixed_string::hashed_fixed_string<16> hashed(buff);
+	EXPECT_STREQ("hi",								hashed.c_str());
+	EXPECT_TRUE(hashed == buff);
+	hashed += buff;
+	EXPECT_STREQ("hihi",							hashed.c_str());
+	char block[256];
+	fixed_string::fixed_string_arena arena(block, sizeof(block));
+	EXPECT_STREQ("hi",								arena.create(16, buff)->c_str());
+
+	// pointers still go through strlen()
+	const char * p = "pointer";
+	fs = p;
+	EXPECT_STREQ("pointer",							fs.c_str());
+	EXPECT_TRUE(fs == p);
+}
+
+TEST(fixed_string, hybrid) {
+	// inline while it fits, like fixed_string<8>
+	fixed_string::hybrid_string<8> hs("abc");
+	hs += "defgh";
+	EXPECT_TRUE(hs.is_inline());
+	EXPECT_EQ(8,									hs.get_capacity());
+	EXPECT_STREQ("abcdefgh",						hs.c_str());
+
+	// then in a buffer of the pool, nothing truncated
+	hs += 'i';
+	EXPECT_FALSE(hs.is_inline());
+	EXPECT_EQ(31,									hs.get_capacity());
+	hs += std::string(30, 'x');
+	EXPECT_EQ(39,									hs.get_used_length());
+	EXPECT_EQ(63,									hs.get_capacity());
+	EXPECT_TRUE(hs > "abcdefghi");
+	EXPECT_EQ(hs.str().hash(),						std::hash<fixed_string::hybrid_string<8> >()(hs));
+
+	// all of fixed_string<0> through edit()
+	hs.edit([](fixed_string::fixed_string<0> & s) { s.erase(9, 30); s.to_upper(); });
+	EXPECT_TRUE(hs == "ABCDEFGHI");
+	hs = "short";
+	EXPECT_FALSE(hs.is_inline());
+	hs.shrink_to_fit();
+	EXPECT_TRUE(hs.is_inline());
+	EXPECT_STREQ("short",							hs.c_str());
+
+	// copies and moves
+	fixed_string::hybrid_string<8> spilled("0123456789");
+	fixed_string::hybrid_string<8> copy(spilled);
+	EXPECT_TRUE(copy == spilled);
+	const char * buffer = spilled.begin();
+	fixed_string::hybrid_string<8> moved(std::move(spilled));
+	EXPECT_EQ(buffer,								moved.begin());
+	EXPECT_EQ(0,									spilled.get_used_length());
+	EXPECT_TRUE(spilled.is_inline());
+	copy = std::move(moved);
+	EXPECT_EQ(buffer,								copy.begin());
+	EXPECT_STREQ("0123456789",						copy.c_str());
+	fixed_string::hybrid_string<16, fixed_string::heap_allocator> other(copy);
+	EXPECT_TRUE(other == copy);
+	EXPECT_TRUE(other <= copy);
+	EXPECT_TRUE(other >= copy);
+	EXPECT_FALSE(other > copy);
+	EXPECT_FALSE(other < copy);
+	other += 'x';
+	EXPECT_TRUE(other > copy);
+	EXPECT_TRUE(copy < other);
+	EXPECT_TRUE(other != copy);
+	other = copy;
+	EXPECT_TRUE(other.is_inline());
+	fixed_string::fixed_string<4> fs(copy);
+	EXPECT_STREQ("0123",							fs.c_str());
+
+	// freed buffers are reused, the pool does not grow
+	const int used = fixed_string::pool_allocator<>::get_used_bytes();
+	for (int i = 0; i < 100; i++) {
+		fixed_string::hybrid_string<8> temp("a string of 25 characters");
+		EXPECT_FALSE(temp.is_inline());
+	}
+	EXPECT_LE(fixed_string::pool_allocator<>::get_used_bytes(), used + 32);
+
+	// a pool that is used up makes it truncate like a fixed_string
+	typedef fixed_string::hybrid_string<8, fixed_string::pool_allocator<64> > small_pool;
+	small_pool a("0123456789");
+	EXPECT_EQ(31,									a.get_capacity());
+	small_pool b("0123456789");
+	small_pool c("0123456789");
+	EXPECT_TRUE(c.is_inline());
+	EXPECT_STREQ("01234567",						c.c_str());
+	EXPECT_EQ('?',									c.str()[-1]);
+	EXPECT_FALSE(c.reserve(9));
+	EXPECT_TRUE(c.reserve(8));
+
+	// appending itself after spilling, while the buffer moves
+	fixed_string::hybrid_string<8> self("0123456789abcdefghij");
+	self += self;
+	EXPECT_EQ(40,									self.get_used_length());
+	EXPECT_STREQ("0123456789abcdefghij0123456789abcdefghij", self.c_str());
+	self += self.c_str();
+	EXPECT_EQ(80,									self.get_used_length());
+	EXPECT_EQ(0,									std::memcmp(self.begin() + 40, self.begin(), 40));
+	fixed_string::hybrid_string<8, fixed_string::heap_allocator> heap_self("0123456789abcdefghij");
+	heap_self += heap_self;
+	EXPECT_STREQ("0123456789abcdefghij0123456789abcdefghij", heap_self.c_str());
+#if __cplusplus >= 201703L
+	// any std::pmr::memory_resource
+	char arena[256];
+	std::pmr::monotonic_buffer_resource resource(arena, sizeof(arena));
+	fixed_string::pmr_allocator allocator(&resource);
+	fixed_string::hybrid_string<8, fixed_string::pmr_allocator> pmr("0123456789", allocator);
+	EXPECT_GE(pmr.begin(),							arena);
+	EXPECT_LT(pmr.begin(),							arena + sizeof(arena));
+	EXPECT_TRUE(pmr.as_view() == "0123456789");
+
+	// a resource that throws makes it truncate instead
+	fixed_string::pmr_allocator throwing(std::pmr::null_memory_resource());
+	fixed_string::hybrid_string<8, fixed_string::pmr_allocator> none("0123456789", throwing);
+	EXPECT_TRUE(none.is_inline());
+	EXPECT_STREQ("01234567",						none.c_str());
+#endif
+}
+
+TEST(fixed_string, trim_case_class) {
+	// long enough for the 16 byte blocks and the tails
+	fixed_string::fixed_string<64> fs(" \t\r\n  Hello, World! 0123456789 ABCdef xyz@[`{  \n\v\f ");
+	fixed_string::fixed_string<64> out;
+	fs.trim_into(out);
+	EXPECT_STREQ("Hello, World! 0123456789 ABCdef xyz@[`{",	out.c_str());
+	out.to_lower();
+	EXPECT_STREQ("hello, world! 0123456789 abcdef xyz@[`{",	out.c_str());
+	out.to_upper();
+	EXPECT_STREQ("HELLO, WORLD! 0123456789 ABCDEF XYZ@[`{",	out.c_str());
+	fs.trim();
+	EXPECT_STREQ("Hello, World! 0123456789 ABCdef xyz@[`{",	fs.c_str());
+	fs.to_lower_into(out);
+	EXPECT_STREQ("hello, world! 0123456789 abcdef xyz@[`{",	out.c_str());
+
+	// bytes above 127 are not letters
+	fs = "\xc3\x84rger \xc3\xa4";
+	fs.to_upper();
+	EXPECT_STREQ("\xc3\x84RGER \xc3\xa4",				fs.c_str());
+
+	// trimming the all space and empty strings
+	fs = "                                   ";
+	fs.rtrim();
+	EXPECT_EQ(0,											fs.get_used_length());
+	fs = " \t ";
+	fs.ltrim();
+	EXPECT_EQ(0,											fs.get_used_length());
+	fs.trim();
+	EXPECT_EQ(0,											fs.get_used_length());
+	fs = "x";
+	fs.trim();
+	EXPECT_STREQ("x",										fs.c_str());
+
+	// removing classes of characters
+	fs = "a\x01" "b\x7f c\t1,2.3";
+	fs.remove_if(fixed_string::chars::control);
+	EXPECT_STREQ("ab c1,2.3",								fs.c_str());
+	fs.remove_if_into(fixed_string::chars::space | fixed_string::chars::punct, out);
+	EXPECT_STREQ("abc123",									out.c_str());
+	fs.remove_if(fixed_string::chars::alpha);
+	EXPECT_STREQ(" 1,2.3",									fs.c_str());
+	EXPECT_FALSE(fs.all_of(fixed_string::chars::digit));
+	fs.remove_if(fixed_string::chars::space | fixed_string::chars::punct);
+	EXPECT_TRUE(fs.all_of(fixed_string::chars::digit));
+	EXPECT_TRUE(fs.all_of(fixed_string::chars::alnum));
+	fs = "0123456789abcdefABCDEF0123456789";
+	EXPECT_TRUE(fs.all_of(fixed_string::chars::xdigit));
+	fs += 'g';
+	EXPECT_FALSE(fs.all_of(fixed_string::chars::xdigit));
+	fs = "";
+	EXPECT_TRUE(fs.all_of(fixed_string::chars::digit));
+
+	// the ..._into() members truncate like append()
+	fixed_string::fixed_string<4> small;
+	fs = "  abcdef  ";
+	fs.trim_into(small);
+	EXPECT_STREQ("abcd",									small.c_str());
+	EXPECT_EQ('?',											small[-1]);
+	fs = "a b c d e";
+	fs.remove_if_into(fixed_string::chars::space, small);
+	EXPECT_STREQ("abcd",									small.c_str());
+	EXPECT_EQ('?',											small[-1]);
+	fs = "a b c d   ";
+	fs.remove_if_into(fixed_string::chars::space, small);
+	EXPECT_STREQ("abcd",									small.c_str());
+	fs = "ABCDEF";
+	fs.to_lower_into(small);
+	EXPECT_STREQ("abcd",									small.c_str());
+	EXPECT_EQ('?',											small[-1]);
+}
+
+TEST(fixed_string, escape) {
+	fixed_string::fixed_string<64> fs;
+	const char raw[] = "say \"hi\"\n\tback\\slash\x01 and a long clean run to scan";
+	fs.append_json_escaped(raw);
+	EXPECT_STREQ("say \\\"hi\\\"\\n\\tback\\\\slash\\u0001 and a long clean run to scan",	fs.c_str());
+	EXPECT_EQ(fs.get_used_length(),					fixed_string::fixed_string<0>::json_escaped_size(raw, sizeof(raw) - 1));
+
+	fixed_string::fixed_string<64> back;
+	EXPECT_TRUE(back.append_json_unescaped(fs));
+	EXPECT_STREQ(raw,								back.c_str());
+
+	// \u escapes and surrogate pairs become UTF-8
+	back = "";
+	EXPECT_TRUE(back.append_json_unescaped("\\u00e9\\ud83d\\ude00\\/"));
+	EXPECT_STREQ("\xc3\xa9\xf0\x9f\x98\x80/",	back.c_str());
+	EXPECT_FALSE(back.append_json_unescaped("\\ud83d"));
+	EXPECT_FALSE(back.append_json_unescaped("\\x"));
+	EXPECT_FALSE(back.append_json_unescaped("\\"));
+	// raw control characters and quotes must be escaped in JSON
+	back = "";
+	EXPECT_FALSE(back.append_json_unescaped("a clean run of text\n"));
+	EXPECT_STREQ("a clean run of text",				back.c_str());
+	EXPECT_FALSE(back.append_json_unescaped("\""));
+
+	// an escape sequence is never cut in half
+	fixed_string::fixed_string<5> small("abc");
+	small.append_json_escaped("\n");
+	EXPECT_STREQ("abc\\n",						small.c_str());
+	small = "abcd";
+	small.append_json_escaped("\n");
+	EXPECT_STREQ("abcd",							small.c_str());
+	EXPECT_EQ('?',									small[-1]);
+
+	// CSV
+	fs = "";
+	fs.append_csv_quoted("plain");
+	EXPECT_STREQ("plain",							fs.c_str());
+	fs = "";
+	fs.append_csv_quoted("a,\"b\"");
+	EXPECT_STREQ("\"a,\"\"b\"\"\"",			fs.c_str());
+	EXPECT_EQ(fs.get_used_length(),					fixed_string::fixed_string<0>::csv_quoted_size("a,\"b\"", 5));
+	back = "";
+	EXPECT_TRUE(back.append_csv_unquoted(fs));
+	EXPECT_STREQ("a,\"b\"",						back.c_str());
+	EXPECT_FALSE(back.append_csv_unquoted("\"a\"b\""));
+	EXPECT_FALSE(back.append_csv_unquoted("\"a"));
+
+	// a cut quoted field keeps its closing quote
+	small = "";
+	small.append_csv_quoted("x,yzzy");
+	EXPECT_STREQ("\"x,y\"",						small.c_str());
+	EXPECT_EQ('?',									small[-1]);
+}
+
+#if defined(FIXEDSTRINGSTATISTICS)
+//! returns the statistics of allocated length l from a snapshot
+static fixed_string::statistics::length_statistics statistics_for(int l) {
+	fixed_string::statistics::length_statistics s[fixed_string::statistics::max_lengths + 1];
+	const int n = fixed_string::statistics::snapshot(s);
+	for (int i = 0; i < n; i++)
+		if (s[i].allocated_length == l)
+			return s[i];
+	fixed_string::statistics::length_statistics none = { l, 0, 0, 0 };
+	return none;
+}
+
+TEST(fixed_string, statistics) {
+	// lengths no other test uses
+	fixed_string::fixed_string<76> fs76("short");
+	EXPECT_EQ(0u,									statistics_for(77).truncations);
+	EXPECT_EQ(5,									statistics_for(77).high_water);
+
+	fixed_string::fixed_string<3> fs3;
+	const fixed_string::statistics::length_statistics before = statistics_for(4);
+	fs3 = "abcdef";
+	fs3 += 'g';
+	fixed_string::statistics::length_statistics after = statistics_for(4);
+	EXPECT_EQ(before.truncations + 2,				after.truncations);
+	EXPECT_EQ(before.overflowed_bytes + 4,			after.overflowed_bytes);
+	EXPECT_EQ(3,									after.high_water);
+
+	// counters of other threads are added up, also when they have finished
+	std::thread t([]() {
+		fixed_string::fixed_string<76> fs("0123456789");
+		fs += "0123456789012345678901234567890123456789012345678901234567890123456789";
+	});
+	t.join();
+	EXPECT_EQ(1u,									statistics_for(77).truncations);
+	EXPECT_EQ(4u,									statistics_for(77).overflowed_bytes);
+	EXPECT_EQ(76,									statistics_for(77).high_water);
+
+	// two running threads with 64 lengths each: a snapshot never
+	// writes more than it has room for, the rest is "other"
+	std::atomic<int> ready(0);
+	std::atomic<bool> done(false);
+	std::thread threads[2];
+	for (int t = 0; t < 2; t++)
+		threads[t] = std::thread([&ready, &done, t]() {
+			for (int l = 0; l < 64; l++)
+				fixed_string::statistics::record_truncation(5000 + 100 * t + l, 1);
+			ready++;
+			while (!done)
+				std::this_thread::yield();
+		});
+	while (ready < 2)
+		std::this_thread::yield();
+	fixed_string::statistics::length_statistics s[9];
+	const int n = fixed_string::statistics::snapshot(s, 8);
+	done = true;
+	threads[0].join();
+	threads[1].join();
+	EXPECT_EQ(8,									n);
+	EXPECT_EQ(-1,									s[7].allocated_length);
+	unsigned long long truncations = 0;
+	for (int i = 0; i < n; i++)
+		truncations += s[i].truncations;
+	EXPECT_GE(truncations,							128u);
+}
+#endif
 
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
@@ -105,6 +105,192 @@
  *
  * these operators have boolean as return values.
  *
+ * \subsection literals string literals
+ *
+ * Constructors, operator=, operator+= and the comparisons take a string literal as a char array. Every char
+ * array, literal, const array or writable buffer, is measured up to its first null character, never past its
+ * end; for a literal the compiler folds that into a constant, and a fixed_string<N> constructed from a literal
+ * no longer than N skips the capacity checks as well.
+ *
+ * \subsection std std::string and std::string_view
+ *
+ * std::strings construct, assign, append to and compare with a fixed_string by their size(), never a
+ * strlen(), so embedded null characters are kept. Compiled as C++17, std::string_view does the same, and a
+ * fixed_string converts implicitly to a std::string_view (or through as_view()) that points at its own
+ * buffer, so passing it to functions taking a std::string_view copies nothing.
+ *
+ * \subsection editing in-place editing
+ *
+ * A fixed_string can be edited in place, without building a new string:
+ * \code
+ * fs.insert(pos, "text");
+ * fs.erase(pos, count);
+ * fs.replace(pos, count, "text");
+ * fs.replace_all("from", "to");
+ * fs.truncate(n);
+ * fs.resize(n, ' ');
+ * \endcode
+ *
+ * Characters that no longer fit in the allocated length are discarded, just like with operator+=.
+ *
+ * \subsection glob glob matching
+ *
+ * fixed_string_match.hpp matches fixed_strings against shell-style patterns ('*' and '?'). When the pattern
+ * is a constexpr char array, it is analysed while compiling:
+ * \code
+ * constexpr char latency_keys[] = "metrics.*.latency";
+ * fixed_string::match<latency_keys>(fs); // compile-time pattern
+ * fixed_string::match("user?_*", fs);     // runtime pattern
+ * \endcode
+ *
+ * \subsection multi multi-pattern search
+ *
+ * aho_corasick<MaxStates, MaxPatterns> (fixed_string_aho_corasick.hpp) looks for many patterns in one pass
+ * over the string. The automaton is built once, without heap, and then answers find_any(), find_all()
+ * and count() for any fixed_string or char buffer.
+ *
+ * \subsection switch keyword switch
+ *
+ * string_table<N> and string_switch<Keys...> (fixed_string_switch.hpp) map a fixed_string to the index of
+ * one of a constant set of keywords, using a perfect hash: one hash and one compare, however many keywords.
+ *
+ * \subsection utf8 UTF-8
+ *
+ * The fixed_string stores bytes, but knows about UTF-8:
+ * \code
+ * fs.is_valid_utf8();   // well-formed UTF-8?
+ * fs.codepoint_count(); // number of code points, not bytes
+ * for (char32_t cp : fs.codepoints()) { }
+ * \endcode
+ *
+ * When UTF8SAFETRUNCATION is defined (see defines.hpp), a string that runs out of room is cut at the last
+ * complete code point, so a multibyte character is never split in half. It is off by default; the runTestsUtf8
+ * target builds the tests with it.
+ *
+ * \subsection arena runtime capacity
+ *
+ * When the maximum length is only known at runtime, fixed_string_arena (fixed_string_arena.hpp) creates
+ * fixed_string<0> objects of any capacity inside a block of memory you provide. All strings are released
+ * at once with reset():
+ * \code
+ * static char block[4096];
+ * fixed_string_arena arena(block, sizeof(block));
+ * fixed_string<0> * fs = arena.create(limit, "hello");
+ * arena.reset();
+ * \endcode
+ *
+ * \subsection hybrid strings that may grow
+ *
+ * For strings that are short nearly always, hybrid_string<N> (fixed_string_hybrid.hpp) keeps up to N
+ * characters inside the object, like fixed_string<N>, and moves to a buffer of an allocator when it grows
+ * past that instead of truncating. The default pool_allocator hands out blocks from a static pool and
+ * reuses freed ones, so no heap is involved; heap_allocator and (C++17) pmr_allocator are the alternatives.
+ * Only when the allocator has no room left does the string truncate. Every fixed_string<0> member is
+ * reached through edit() and str().
+ *
+ * \subsection batch batch operations
+ *
+ * fixed_string_batch.hpp applies one operation to an array of fixed_strings: transform_all(), hash_all(),
+ * count_if() and find_equal_all(). Pass a batch_pool to split the array over its threads; results are
+ * always in array order.
+ * \code
+ * batch_pool pool(8);
+ * hash_all(&pool, strings, count, hashes);
+ * \endcode
+ *
+ * \subsection serial serialization
+ *
+ * fixed_string_serial.hpp writes fixed_strings as varint length + characters, or as fixed-width padded
+ * records, and reads them back either with one memcpy or as a view into the receive buffer.
+ *
+ * \subsection codec hex and base64
+ *
+ * append_hex() and append_base64() append binary data as text, decode_hex_into() and
+ * decode_base64_into() turn the string back into bytes. The output size is known in advance, so the room
+ * is checked once: a conversion that does not fit changes nothing and returns false (or -1). Hex is
+ * converted 16 bytes at a time with SSE2.
+ *
+ * \subsection timestamp timestamps
+ *
+ * append_timestamp(fs, time_point, precision) (fixed_string_time.hpp) appends an ISO-8601 UTC timestamp
+ * such as 2024-05-06T07:08:09.123Z, the same text strftime and snprintf would give. Each thread keeps the
+ * date and time of the last second it formatted, so most calls only write the fraction of the second.
+ *
+ * \subsection escape JSON and CSV escaping
+ *
+ * append_json_escaped() and append_csv_quoted() write a string escaped for a JSON string or as a CSV field;
+ * append_json_unescaped() and append_csv_unquoted() undo that and return false on malformed input. Clean
+ * runs are found 16 (SSE2) or 8 bytes at a time and copied in bulk, and an escape sequence is never cut in
+ * half. json_escaped_size() and csv_quoted_size() tell how much room the result needs.
+ *
+ * \subsection normalize trimming, case and character classes
+ *
+ * trim(), ltrim() and rtrim() remove whitespace, to_lower() and to_upper() convert ASCII letters and leave
+ * every other byte alone, remove_if() drops the characters of some classes (chars::space, chars::punct,
+ * chars::control, ...) and all_of() tests that every character is in them. The _into() variants write the
+ * result to another fixed_string without an intermediate copy. Whitespace scans and case conversion work 16
+ * characters at a time with SSE2; the classes are a 256-entry table, so no locale is involved.
+ *
+ * \subsection terminator deferred null-terminator
+ *
+ * Define DEFERREDTERMINATOR to have append(char) and += char update only the length; c_str() writes the
+ * null-terminator when it is called. This halves the stores of loops that build a string one character
+ * at a time. begin(), end(), comparisons and everything that takes the length never need the terminator.
+ * c_str() is then no longer a pure read: threads that share a const fixed_string should not call it at
+ * the same time.
+ *
+ * \subsection hashed cached hash
+ *
+ * fixed_strings can be keys of std::unordered_map and friends. For keys that are looked up far more often
+ * than they change, fixed_string_hashed.hpp has hashed_fixed_string<N>: it keeps its hash up to date on
+ * every append, so hashing costs O(1), and two of them compare hash and length before their characters.
+ * Other changes go through edit(), which recomputes the hash once the change is done; reading the hash never
+ * writes, so a const hashed_fixed_string can be shared between threads.
+ *
+ * \subsection trie prefix lookups
+ *
+ * fixed_string_trie<N, V, MaxNodes> (fixed_string_trie.hpp) is a radix tree from keys of up to N
+ * characters to values, with all nodes in a static pool. Besides insert() and find() it answers
+ * longest_prefix(), the longest stored key that starts a string, and for_each_prefix(), all keys under a
+ * prefix in sorted order.
+ * \code
+ * static fixed_string_trie<64, handler, 1024> routes;
+ * routes.insert("eu/host7/", host7_handler);
+ * const handler * h = routes.longest_prefix("eu/host7/cpu");
+ * \endcode
+ *
+ * \subsection sorted sorted set
+ *
+ * sorted_fixed_string_set<N, MaxElements> (fixed_string_sorted_set.hpp) is built once from an unsorted
+ * array and then answers contains(), lower_bound(), upper_bound() and range() by index in sorted order.
+ * The search compares the first 8 characters of each element as one big-endian integer, in a
+ * breadth-first (Eytzinger) layout; the rest of the characters only decides between equal integers.
+ *
+ * \subsection bloom Bloom filters
+ *
+ * fixed_string_bloom.hpp has bloom_filter<MaxKeys, BitsPerKey> and blocked_bloom_filter<MaxKeys,
+ * BitsPerKey>, statically sized filters that tell for certain that a key was never inserted, so the
+ * lookup behind it can be skipped. BitsPerKey sets the false positive rate (10 bits: about 1 %); the
+ * blocked filter keeps all bits of a key in one cache line. insert_all() and maybe_contains_all() work on
+ * arrays of fixed_strings.
+ *
+ * \subsection log asynchronous logging
+ *
+ * fixed_string_logger<N, Slots> (fixed_string_log.hpp) lets any thread format a log record straight into a
+ * fixed_string<N> slot of a ring; a background thread writes the records to a file descriptor, many per
+ * writev(). Memory use is fixed at compile time. When the ring is full, records are dropped (and counted)
+ * or the logging thread waits, as chosen at construction.
+ * \code
+ * static fixed_string_logger<256, 1024> log(STDERR_FILENO);
+ * log.log([&](fixed_string<0> & r) { r += "request "; r += path; });
+ * \endcode
+ *
+ * \subsection statistics truncation statistics
+ *
+ * Define FIXEDSTRINGSTATISTICS to count, per allocated length, how often strings run out of room, how many
+ * characters they discard and the longest length they reach. fixed_string::statistics::print(std::cout)
+ * writes the counters of all threads as CSV; use them to pick the right N for your strings.
+ *
  * \subsection todo
  * The following is tested:
  * \li
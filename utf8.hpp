@@ -0,0 +1,190 @@
+/*  The MIT License (MIT)
+ * Copyright (c) 2014 FMBroers
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * utf8.hpp
+ *
+ *  Helper routines for the UTF-8 aware operations of fixed_string.
+ *  All routines work on a (pointer, length) pair, never allocate
+ *  and never read outside [s, s + len).
+ */
+
+#ifndef UTF8_HPP_
+#define UTF8_HPP_
+
+#include <cstring>
+#include <stdint.h>
+
+namespace fixed_string {
+namespace utf8 {
+
+//! replacement character returned when decoding an invalid sequence
+static const char32_t replacement_char = 0xFFFD;
+
+//! returns true if c is a continuation byte (10xxxxxx)
+inline bool is_continuation(unsigned char c) {
+	return (c & 0xC0) == 0x80;
+}
+
+//! returns the length of the sequence started by lead byte c,
+//! or 0 if c cannot start a sequence (continuation byte, 0xF8..0xFF)
+inline int sequence_length(unsigned char c) {
+	if (c < 0x80)
+		return 1;
+	if (c < 0xC0)
+		return 0;
+	if (c < 0xE0)
+		return 2;
+	if (c < 0xF0)
+		return 3;
+	if (c < 0xF8)
+		return 4;
+	return 0;
+}
+
+//! loads 8 bytes without alignment requirements; the memcpy
+//! compiles to a single load on every target we care about
+inline uint64_t load_word(const char * s) {
+	uint64_t w;
+	std::memcpy(&w, s, sizeof(w));
+	return w;
+}
+
+//! mask with the high bit of every byte in a 64 bit word
+static const uint64_t high_bits = 0x8080808080808080ULL;
+
+//! Validates a single multibyte sequence starting at s[0].
+//! Returns the length of the sequence, or 0 if it is invalid
+//! (truncated, overlong, surrogate or beyond U+10FFFF).
+inline int validate_sequence(const unsigned char * s, int len) {
+	const int n = sequence_length(s[0]);
+	if (n < 2 || n > len)
+		return 0;
+	for (int i = 1; i < n; i++)
+		if (!is_continuation(s[i]))
+			return 0;
+	switch (n) {
+	case 2:
+		// C0 and C1 are always overlong
+		return s[0] >= 0xC2 ? 2 : 0;
+	case 3:
+		if (s[0] == 0xE0 && s[1] < 0xA0) // overlong
+			return 0;
+		if (s[0] == 0xED && s[1] >= 0xA0) // surrogates
+			return 0;
+		return 3;
+	default:
+		if (s[0] == 0xF0 && s[1] < 0x90) // overlong
+			return 0;
+		if (s[0] > 0xF4 || (s[0] == 0xF4 && s[1] >= 0x90)) // > U+10FFFF
+			return 0;
+		return 4;
+	}
+}
+
+//! Returns true if [s, s + len) is well-formed UTF-8.
+//! ASCII runs are skipped 8 bytes at a time (word-at-a-time, so
+//! it also runs at full speed on targets without vector units);
+//! only the bytes around non-ASCII characters are decoded.
+inline bool validate(const char * s, int len) {
+	const unsigned char * p = reinterpret_cast<const unsigned char *>(s);
+	int i = 0;
+	while (i < len) {
+		while (i + 8 <= len && (load_word(s + i) & high_bits) == 0)
+			i += 8;
+		if (i >= len)
+			break;
+		if (p[i] < 0x80) {
+			i++;
+			continue;
+		}
+		const int n = validate_sequence(p + i, len - i);
+		if (n == 0)
+			return false;
+		i += n;
+	}
+	return true;
+}
+
+//! Returns the number of code points in [s, s + len), which is the
+//! number of bytes that are not continuation bytes. Counted 8 bytes
+//! at a time: a continuation byte has bit 7 set and bit 6 cleared.
+inline int count_codepoints(const char * s, int len) {
+	int continuation = 0;
+	int i = 0;
+	for (; i + 8 <= len; i += 8) {
+		const uint64_t w = load_word(s + i);
+		const uint64_t cont = w & ~(w << 1) & high_bits;
+#if defined(__GNUC__)
+		continuation += __builtin_popcountll(cont);
+#else
+		for (uint64_t m = cont; m; m &= m - 1)
+			continuation++;
+#endif
+	}
+	for (; i < len; i++)
+		if (is_continuation(s[i]))
+			continuation++;
+	return len - continuation;
+}
+
+//! Returns the length to which [s, s + len) has to be shortened so it
+//! does not end in an incomplete multibyte sequence. Only the last
+//! (at most four) bytes are inspected.
+inline int complete_length(const char * s, int len) {
+	const unsigned char * p = reinterpret_cast<const unsigned char *>(s);
+	int i = len - 1;
+	while (i >= 0 && i > len - 4 && is_continuation(p[i]))
+		i--;
+	if (i < 0)
+		return len;
+	const int n = sequence_length(p[i]);
+	return (n > len - i) ? i : len;
+}
+
+//! Decodes the code point at s[0] and stores its length in bytes in
+//! n. Invalid sequences decode to replacement_char with length 1, so
+//! the caller always makes progress.
+inline char32_t decode(const char * s, int len, int & n) {
+	const unsigned char * p = reinterpret_cast<const unsigned char *>(s);
+	if (p[0] < 0x80) {
+		n = 1;
+		return p[0];
+	}
+	n = validate_sequence(p, len);
+	switch (n) {
+	case 2:
+		return ((p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+	case 3:
+		return ((p[0] & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+	case 4:
+		return ((p[0] & 0x07) << 18) | ((p[1] & 0x3F) << 12)
+				| ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+	default:
+		n = 1;
+		return replacement_char;
+	}
+}
+
+} // namespace utf8
+} // namespace fixed_string
+
+#endif /* UTF8_HPP_ */